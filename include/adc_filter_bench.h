@@ -0,0 +1,5 @@
+#pragma once
+
+// Build with -D ADC_FILTER_BENCH to log cycles and accuracy of every ADC filter
+// policy at boot; compiled out otherwise.
+void runAdcFilterBenchmark();
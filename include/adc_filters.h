@@ -0,0 +1,155 @@
+#pragma once
+#include <stdint.h>
+
+// Integer-only filters that reduce one burst of raw ADC reads to a single value.
+// Each policy exposes SAMPLES (burst length) and apply(samples); pick one per
+// channel with a type alias and the whole kernel is inlined at compile time.
+//
+//   BurstMean<N>               plain average, one pass
+//   SigmaGatedMean<N, K[, D]>  average of samples within K/D sigma of the mean, two passes, no sqrt per sample
+//   MedianOfN<N>               median via a Batcher odd-even merge sorting network
+//   TrimmedMean<N, T>          sorting network, drop T lowest and T highest, average the rest
+//   Smoothed<Base, Shift>      exponential smoothing across bursts, alpha = 1 / 2^Shift
+
+namespace adc_filter_detail {
+
+inline void compareExchange(int* v, int i, int j) {
+    int a = v[i], b = v[j];
+    v[i] = a < b ? a : b;
+    v[j] = a < b ? b : a;
+}
+
+// Batcher odd-even merge sort. The comparison sequence depends only on N, so it
+// is a sorting network: no data-dependent branches and fully unrollable.
+template <int N>
+inline void sortingNetwork(int* v) {
+    for (int p = 1; p < N; p += p) {
+        for (int k = p; k >= 1; k /= 2) {
+            for (int j = k % p; j + k < N; j += 2 * k) {
+                for (int i = 0; i < k && i + j + k < N; i++) {
+                    if ((i + j) / (2 * p) == (i + j + k) / (2 * p)) compareExchange(v, i + j, i + j + k);
+                }
+            }
+        }
+    }
+}
+
+inline uint32_t isqrt64(uint64_t x) {
+    uint64_t result = 0;
+    uint64_t bit = 1ULL << 62;
+    while (bit > x) bit >>= 2;
+    while (bit != 0) {
+        if (x >= result + bit) {
+            x -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)result;
+}
+
+} // namespace adc_filter_detail
+
+template <int N>
+struct BurstMean {
+    static constexpr int SAMPLES = N;
+
+    int apply(const int* samples) {
+        int32_t sum = 0;
+        for (int i = 0; i < N; i++) sum += samples[i];
+        return sum / N;
+    }
+};
+
+// |x - mean| <= (K/D) * sigma  <=>  D * |N*x - S| <= sqrt(K^2 * (N*Q - S^2))
+// with S = sum and Q = sum of squares, so the gate is one isqrt per burst and
+// one 32-bit compare per sample. Falls back to the plain mean if every sample
+// is rejected.
+template <int N, int K, int D = 1>
+struct SigmaGatedMean {
+    static constexpr int SAMPLES = N;
+    static_assert(N >= 5, "Sigma gating needs at least 5 samples for a meaningful sigma estimate");
+    static_assert((uint64_t)N * 4095u * 4095u <= UINT32_MAX, "Sum of squares of 12-bit samples overflows 32 bits above 256 samples");
+
+    int apply(const int* samples) {
+        int32_t  sum   = 0;
+        uint32_t sumSq = 0;
+        for (int i = 0; i < N; i++) {
+            sum   += samples[i];
+            sumSq += (uint32_t)(samples[i] * samples[i]);
+        }
+
+        int64_t  spread = (int64_t)N * sumSq - (int64_t)sum * sum;  // N^2 * variance
+        uint32_t gate   = adc_filter_detail::isqrt64((uint64_t)K * K * (uint64_t)spread);
+
+        int32_t gatedSum = 0;
+        int     count    = 0;
+        for (int i = 0; i < N; i++) {
+            int32_t dev = N * samples[i] - sum;
+            if (dev < 0) dev = -dev;
+            if ((uint32_t)(D * dev) <= gate) {
+                gatedSum += samples[i];
+                count++;
+            }
+        }
+
+        if (count == 0) return sum / N;
+        return gatedSum / count;
+    }
+};
+
+template <int N>
+struct MedianOfN {
+    static constexpr int SAMPLES = N;
+
+    int apply(const int* samples) {
+        int v[N];
+        for (int i = 0; i < N; i++) v[i] = samples[i];
+        adc_filter_detail::sortingNetwork<N>(v);
+
+        if (N % 2) return v[N / 2];
+        return (v[N / 2 - 1] + v[N / 2]) / 2;
+    }
+};
+
+template <int N, int T>
+struct TrimmedMean {
+    static constexpr int SAMPLES = N;
+    static_assert(2 * T < N, "TrimmedMean must keep at least one sample");
+
+    int apply(const int* samples) {
+        int v[N];
+        for (int i = 0; i < N; i++) v[i] = samples[i];
+        adc_filter_detail::sortingNetwork<N>(v);
+
+        int32_t sum = 0;
+        for (int i = T; i < N - T; i++) sum += v[i];
+        return sum / (N - 2 * T);
+    }
+};
+
+// Wraps a burst policy with a first-order IIR across bursts. State is kept in
+// 24.8 fixed point so small steps are not lost to rounding; the first burst
+// seeds the filter.
+template <typename Base, int Shift>
+struct Smoothed {
+    static constexpr int SAMPLES = Base::SAMPLES;
+    static_assert(Shift >= 1 && Shift <= 8, "Smoothing shift must be 1..8");
+
+    Base    base;
+    int32_t state  = 0;
+    bool    primed = false;
+
+    int apply(const int* samples) {
+        int32_t x = (int32_t)base.apply(samples) << 8;
+        if (!primed) {
+            state  = x;
+            primed = true;
+        } else {
+            state += (x - state) >> Shift;
+        }
+        return (state + 128) >> 8;
+    }
+};
@@ -19,6 +19,8 @@
 // --- SD Card (D Pin) ---
 // Pin 5 is standard for SD Chip Select on Feathers.
 #define SD_CS_PIN 5         // Digital Pin 5
+#define SD_MAX_OPEN_FILES 8 // run CSV + sidecars during a flush, plus web downloads
+#define RUN_META_DIR "/meta" // per-run sidecar files; kept out of the root so /runs lists only runs
 
 // --- Analog Inputs (Keep on Analog Side) ---
 // We keep these on the Analog header (A3/A4) because D5-D13 are digital.
@@ -37,9 +39,33 @@
 // Battery % is read from the MAX17048 fuel gauge IC over I2C (address 0x36, SDA=3, SCL=4)
 #define BATTERY_READ_INTERVAL_MS 30000UL
 
+// --- Logging ---
+// LOG_LEVEL (compile-time filter) is set in platformio.ini build_flags.
+const bool LOG_SINK_SD = false;     // also append log output to SYSTEM_LOG_PATH
+#define SYSTEM_LOG_PATH RUN_META_DIR "/system.log"
+
 // --- Constants ---
-const unsigned long SAMPLE_PERIOD_MS = 10;
-const unsigned int SAMPLE_FREQUENCY = 1000 / SAMPLE_PERIOD_MS;
-const size_t MAX_BUFFER_SIZE = 512;
+// DataTask is clocked by an esp_timer at any whole rate in this range. The rate
+// for the next run is set via /sampleRate and recorded in /meta/run_N.info.
+const uint32_t DEFAULT_SAMPLE_RATE_HZ = 100;
+const uint32_t MIN_SAMPLE_RATE_HZ = 20;
+const uint32_t MAX_SAMPLE_RATE_HZ = 500;   // above 250 Hz the ADC uses short bursts so a pass fits in the period
+const size_t MAX_BUFFER_SIZE = 512;                    // lines per regular flush
+const size_t FLUSH_RETRY_INTERVAL = 16;                // samples between retries of a flush that could not open the run
+const size_t SENSOR_BUFFER_CAPACITY = 2 * MAX_BUFFER_SIZE;  // lines held while retrying; beyond this they are dropped
+const uint32_t SEEK_INDEX_INTERVAL = 100;   // samples between seek-index entries (1 s at 100 Hz)
+
+// --- Armed Mode / Auto Trigger ---
+// While armed (after the first button press) DataTask samples continuously into a
+// fixed RAM ring holding PRETRIGGER_MS of history. A motion trigger starts recording
+// and the ring is written to the run file ahead of the live samples.
+const bool AUTO_TRIGGER_ENABLED = true;
+const unsigned long PRETRIGGER_MS = 3000;
+const size_t PRETRIGGER_MAX_SAMPLES = PRETRIGGER_MS * MAX_SAMPLE_RATE_HZ / 1000;  // 48 KB
+const size_t PRETRIGGER_FLUSH_CHUNK = 128;             // ring lines written per flush after a trigger
+const size_t PRETRIGGER_DRAIN_INTERVAL = 16;           // live samples between those flushes
+const int AUTO_TRIGGER_ACCEL_MG = 350;                 // any world-frame axis, gravity removed
+const long AUTO_TRIGGER_SUS_VELOCITY = 10000;          // corrected counts per second, fork or shock
+const unsigned long AUTO_STOP_QUIET_MS = 20000;        // auto-triggered runs stop after this long without motion
 static const char* LOCAL_SERVER_URL = "http://192.168.1.181:3001/api/s3/newRunFile";
 static const char* EXTERNAL_SERVER_URL = "https://backend-production-68e1.up.railway.app/api/s3/newRunFile";
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+#include <Arduino.h>
+#include <type_traits>
+
+// Deferred logging. A LOG_* call packs its format pointer and up to LOG_MAX_ARGS
+// 32-bit arguments into a fixed-size record in the calling core's ring; the log
+// task on core 1 formats records and writes them to Serial (and optionally the SD
+// system log). The producer never formats, allocates or touches Serial.
+//
+// Format strings must be literals. %s arguments are stored as pointers, so they
+// must also outlive the record (literals, sdStateName() etc.); code off the
+// sampling path that needs to print runtime Strings can keep using Serial.
+// Length modifiers (l, z, h) are accepted and ignored: every argument is 32 bits.
+
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+static constexpr int      LOG_MAX_ARGS  = 10;
+static constexpr uint32_t LOG_RING_SIZE = 64;  // records per core; power of two
+static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0, "LOG_RING_SIZE must be a power of two");
+
+struct LogRecord {
+    const char* fmt;
+    uint32_t    timestampUs;
+    uint8_t     level;
+    uint8_t     argCount;
+    uint32_t    args[LOG_MAX_ARGS];
+};
+
+template <typename T>
+inline uint32_t packLogArg(T value) {
+    if constexpr (std::is_floating_point<T>::value) {
+        float f = (float)value;
+        uint32_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        return bits;
+    } else if constexpr (std::is_pointer<T>::value) {
+        return (uint32_t)(uintptr_t)value;
+    } else {
+        static_assert(std::is_integral<T>::value || std::is_enum<T>::value, "Log arguments must be numbers or C strings");
+        return (uint32_t)value;
+    }
+}
+
+void logPush(uint8_t level, const char* fmt, const uint32_t* args, uint8_t argCount);
+
+template <typename... Args>
+inline void logDeferred(uint8_t level, const char* fmt, Args... args) {
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "Too many log arguments");
+    const uint32_t packed[sizeof...(Args) + 1] = { packLogArg(args)..., 0 };
+    logPush(level, fmt, packed, sizeof...(Args));
+}
+
+// Calls below LOG_LEVEL compile away; arguments are still type-checked.
+#define LOG_AT(level, ...) do { if ((level) <= LOG_LEVEL) logDeferred((level), __VA_ARGS__); } while (0)
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_WARN(...)  LOG_AT(LOG_LEVEL_WARN,  __VA_ARGS__)
+#define LOG_INFO(...)  LOG_AT(LOG_LEVEL_INFO,  __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+void startLogTask();
+uint32_t logDroppedCount();
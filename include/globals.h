@@ -7,6 +7,8 @@
 
 extern AsyncWebServer server;
 extern volatile int recording;
+extern volatile uint32_t activeSampleRateHz;     // rate DataTask is clocked at now
+extern volatile uint32_t requestedSampleRateHz;  // applied when the next run is armed
 
 extern String currentRunFilePath;
 
@@ -2,6 +2,14 @@
 #include <Adafruit_LSM6DS3TRC.h>
 #include "storage_manager.h"
 
+// Running sums for one zero-motion detection window. Samples are accumulated as
+// offsets from the window's first reading so float variance stays precise near 1 g.
+struct StillWindow {
+    float refG[3] = {}, sumG[3] = {}, sumG2[3] = {};
+    float refA[3] = {}, sumA[3] = {}, sumA2[3] = {};
+    int   count   = 0;
+};
+
 // Holds all IMU hardware state and calibration results.
 // Identity rotation matrix and standard gravity are safe defaults before calibration.
 struct ImuState {
@@ -15,8 +23,17 @@ struct ImuState {
     float accelBias[3] = {};
     float R[3][3]    = {{1,0,0},{0,1,0},{0,0,1}};
     float gravMag    = 9.806f;
+
+    // Background bias tracking: every reading feeds `still`; each window that passes
+    // the zero-motion test refines gyroBias, accelBias and R.
+    StillWindow still;
+    int  stillWindowSamples = DEFAULT_SAMPLE_RATE_HZ / 2;  // 0.5 s at the active rate
+    bool biasValid   = false;  // a still window or calibrateImu() has set the biases
+    bool biasUpdated = false;  // set on each update; cleared by the caller once logged
 };
 
 void initImu(ImuState& imu);
+void setImuSampleRate(ImuState& imu, uint32_t rateHz);
 void calibrateImu(ImuState& imu);
+void trackImuBias(ImuState& imu);
 void populateImuReadingIntoLine(ImuState& imu, SensorLine& line);
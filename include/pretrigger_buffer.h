@@ -0,0 +1,30 @@
+#pragma once
+#include "storage_manager.h"
+
+// Fixed-size ring of the most recent samples taken while armed.
+// Statically allocated so the sampling loop never touches the heap; `depth`
+// is PRETRIGGER_MS worth of samples at the active rate.
+struct PretriggerRing {
+    SensorLine lines[PRETRIGGER_MAX_SAMPLES];
+    size_t depth  = PRETRIGGER_MAX_SAMPLES;
+    size_t head   = 0;      // next slot to overwrite
+    size_t count  = 0;
+    size_t drained = 0;     // lines of a frozen ring already written to the run file
+    uint32_t pushed = 0;    // samples pushed since reset; the oldest held is pushed - count
+    bool   frozen = false;  // set on trigger; contents are drained over the next flushes
+};
+
+// Draining the largest ring must finish before the live samples queued behind it
+// fill sensorBuffer.
+static_assert((PRETRIGGER_MAX_SAMPLES + PRETRIGGER_FLUSH_CHUNK - 1) / PRETRIGGER_FLUSH_CHUNK
+                  * PRETRIGGER_DRAIN_INTERVAL < MAX_BUFFER_SIZE,
+              "Pre-trigger drain would overflow sensorBuffer");
+
+extern PretriggerRing pretriggerRing;
+
+void resetPretrigger();
+void pushPretriggerSample(const SensorLine& line);
+void freezePretrigger();
+bool hasPendingPretrigger();
+size_t pretriggerPending();  // frozen lines not yet written
+const SensorLine& pretriggerLineAt(size_t i);  // 0 = oldest
@@ -0,0 +1,18 @@
+#pragma once
+#include <stdint.h>
+
+// Sampling cadence against a free-running microsecond counter. Deadline k is
+// start + k * 1e6 / rate, computed exactly each time, so non-integer periods
+// (e.g. 300 Hz = 3333.3 us) never accumulate drift. Pure logic with time passed
+// in: sample_timer.cpp drives it from esp_timer, a host build can drive it with
+// simulated time.
+struct SampleSchedule {
+    uint32_t rateHz  = 0;
+    int64_t  startUs = 0;
+    uint64_t tick    = 0;  // index of the deadline currently armed
+    uint32_t skipped = 0;  // deadlines that passed before the clock was serviced
+};
+
+void     scheduleStart(SampleSchedule& s, uint32_t rateHz, int64_t nowUs);
+int64_t  scheduleDeadlineUs(const SampleSchedule& s);
+uint32_t scheduleAdvance(SampleSchedule& s, int64_t nowUs);
@@ -0,0 +1,13 @@
+#pragma once
+#include <Arduino.h>
+
+// esp_timer-driven sampling clock. Each deadline of the SampleSchedule wakes the
+// sampling task through its task notification.
+
+// Longest backlog the sampling loop works off back to back, far above any SD
+// write-latency spike; only ticks beyond it are dropped and counted as skipped.
+static constexpr uint32_t SAMPLE_MAX_CATCHUP_MS = 1000;
+bool sampleTimerStart(TaskHandle_t task, uint32_t rateHz);
+void sampleTimerSetRate(uint32_t rateHz);  // restarts the schedule and drops pending ticks
+uint32_t sampleTimerWait();                // blocks for the next tick; returns ticks pending incl. this one
+uint32_t sampleTimerSkipped();             // deadlines serviced too late or dropped from the backlog
@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+// SD card mount lifecycle. The card is mounted once at boot; afterwards only
+// sdMountTick() (WiFiTask, core 1) probes, unmounts or remounts it, so the
+// sampling and web paths just check sdMounted() and never pay for a remount.
+// Hardware-free so the state machine can be driven by a fake BlockDevice on a host.
+
+static constexpr uint32_t SD_PROBE_PERIOD_MS        = 1000;
+static constexpr uint32_t SD_REMOUNT_BACKOFF_MIN_MS = 250;
+static constexpr uint32_t SD_REMOUNT_BACKOFF_MAX_MS = 8000;
+
+struct BlockDevice {
+    virtual ~BlockDevice() = default;
+    virtual bool mount()   = 0;
+    virtual void unmount() = 0;
+    virtual bool probe()   = 0;  // cheap raw read; false once the card is gone
+};
+
+enum class SdState : uint8_t { Unmounted = 0, Mounted = 1, Lost = 2 };
+
+struct SdMount {
+    BlockDevice* device = nullptr;
+    std::atomic<SdState> state{SdState::Unmounted};
+    std::atomic<bool>    failureReported{false};
+    uint32_t nextActionMs = 0;   // next probe when mounted, next remount attempt otherwise
+    uint32_t backoffMs    = SD_REMOUNT_BACKOFF_MIN_MS;
+    uint32_t mountCount   = 0;
+    uint32_t lostCount    = 0;
+};
+
+extern SdMount sdMount;
+
+bool sdMountBegin(SdMount& m, BlockDevice& device, uint32_t nowMs);
+void sdMountTick(SdMount& m, uint32_t nowMs);
+void sdReportFailure(SdMount& m);
+const char* sdStateName(SdState state);
+
+inline bool sdMounted() { return sdMount.state.load() == SdState::Mounted; }
@@ -1,5 +1,8 @@
 #pragma once
 #include <vector>
+#include <memory>
+#include <Arduino.h>
+#include <FS.h>
 #include "config.h"
 
 struct SensorLine {
@@ -8,8 +11,56 @@ struct SensorLine {
     int front_sus;
 };
 
-extern std::vector<SensorLine> sensorBuffer;
+// One online IMU bias/world-frame update, stamped with the index of the first
+// run sample it applies to. While armed that index is not known yet, so `sample`
+// holds a pre-trigger ring position until anchorArmedBiasUpdates() converts it.
+struct BiasUpdate {
+    uint32_t sample;
+    bool     inRing;
+    float gyroBias[3];
+    float accelBias[3];
+    float gravMag;
+};
+
+// Samples that never reached the run file: `missing` samples were lost just
+// before CSV row `sample`. Written to /meta/run_N.gaps so readers can keep the
+// rows after a gap at their true time.
+struct SampleGap {
+    uint32_t sample;
+    uint32_t missing;
+};
+
+extern std::vector<SensorLine> sensorBuffer;  // reserved to SENSOR_BUFFER_CAPACITY
 
 bool initStorage();
-void startNewRun(const int initialAcc[6]);
-void flushSensorBuffer();
\ No newline at end of file
+void storageTick();  // mount manager heartbeat; called from WiFiTask
+bool startNewRun(const int initialAcc[6], uint32_t rateHz);  // false (and no current run) on failure
+void flushSensorBuffer();
+void finishRun();  // final flush plus the trailing partial summary buckets
+void appendSystemLog(const char* data, size_t len);
+void logBiasUpdate(const float gyroBias[3], const float accelBias[3], float gravMag);
+void anchorArmedBiasUpdates();  // call once the trigger has frozen the pre-trigger ring
+void logSampleGap(uint32_t missing);  // samples lost ahead of the next one captured
+
+String runSidecarPath(const String& runPath, const char* suffix);
+String summaryPath(const String& runPath, int level);
+String seekIndexPath(const String& runPath);
+void removeRunSidecars(const String& runPath);
+uint32_t readRunSampleRate(const String& runPath);  // from /meta/run_N.info; 100 Hz for older runs
+
+// Web handlers (async_tcp task) do their SD work between lockSdIo() and
+// unlockSdIo(), the lock flushes and the mount manager also take, and stream
+// downloads through an SdStream.
+bool lockSdIo(TickType_t wait);  // false, lock not held, if the card is not mounted or stays busy
+void unlockSdIo();
+
+// A file a web response reads across many callbacks. Open streams are counted
+// so an unmount waits until they have noticed the lost card and closed.
+struct SdStream {
+    File file;
+    bool open = false;
+    ~SdStream();
+};
+
+std::shared_ptr<SdStream> openSdStream(const String& path);  // lock held; nullptr if it cannot be opened
+void closeSdStream(SdStream& stream);                         // takes the lock; release it first
@@ -0,0 +1,42 @@
+#pragma once
+#include <FS.h>
+#include "storage_manager.h"
+
+// Per-channel min/max/mean summaries at several time resolutions, built while a
+// run is flushed and written as fixed-size records to one sidecar file per level.
+// Record k of level L covers [k * PYRAMID_LEVEL_MS[L], (k + 1) * PYRAMID_LEVEL_MS[L]).
+
+static constexpr int PYRAMID_CHANNELS = 8;  // 6 IMU axes, rear_sus, front_sus (CSV column order)
+static constexpr int PYRAMID_LEVELS   = 3;
+static constexpr uint32_t PYRAMID_LEVEL_MS[PYRAMID_LEVELS] = { 100, 1000, 10000 };
+
+static_assert(PYRAMID_LEVEL_MS[1] % PYRAMID_LEVEL_MS[0] == 0 && PYRAMID_LEVEL_MS[2] % PYRAMID_LEVEL_MS[1] == 0,
+              "Each pyramid level must be a whole number of the level below");
+
+struct PyramidRecord {
+    int32_t min[PYRAMID_CHANNELS];
+    int32_t max[PYRAMID_CHANNELS];
+    int32_t mean[PYRAMID_CHANNELS];
+};
+
+// Open bucket for one level. Level 0 folds in raw samples, higher levels fold in
+// closed buckets from the level below, so each sample costs one pass over 8 channels.
+struct PyramidBucket {
+    int32_t  min[PYRAMID_CHANNELS];
+    int32_t  max[PYRAMID_CHANNELS];
+    int64_t  sum[PYRAMID_CHANNELS];
+    uint32_t samples;
+    uint32_t children;
+};
+
+// Level 0 closes on time rather than sample count, so rates that don't divide
+// PYRAMID_LEVEL_MS[0] evenly (e.g. 333 Hz) still produce one record per 100 ms.
+struct SummaryPyramid {
+    PyramidBucket levels[PYRAMID_LEVELS];
+    uint32_t rateHz;
+    uint64_t sampleIndex;  // samples folded in so far
+};
+
+void resetPyramid(SummaryPyramid& pyr, uint32_t rateHz);
+void pyramidAddSample(SummaryPyramid& pyr, const SensorLine& line, File out[PYRAMID_LEVELS]);
+void pyramidFinish(SummaryPyramid& pyr, File out[PYRAMID_LEVELS]);
@@ -0,0 +1,7 @@
+#pragma once
+#include <ESPAsyncWebServer.h>
+
+// Dashboard assets built by scripts/build_web_assets.py: gzipped in LittleFS,
+// listed with their content-hash ETags in /assets.txt.
+bool initWebAssets();
+void setupAssetRoutes();
@@ -0,0 +1,135 @@
+"""Build-time pipeline for the dashboard assets served from LittleFS.
+
+Reads the sources in data/, minifies them conservatively, rewrites asset
+references in HTML to carry a content-hash query (?v=<hash>) so CSS/JS can be
+cached for a year, gzips everything and writes the result plus a manifest to
+data_build/ (the LittleFS image source, see data_dir in platformio.ini).
+
+manifest: data_build/assets.txt, one "<url-path> <etag>" line per asset.
+
+Runs as a PlatformIO pre-script on every build, or standalone:
+    python scripts/build_web_assets.py
+"""
+import gzip
+import hashlib
+import os
+import re
+import shutil
+
+SRC_DIR = "data"
+OUT_DIR = "data_build"
+MANIFEST = "assets.txt"
+HASH_LEN = 12
+
+
+CSS_STRING = r"\"(?:\\.|[^\"\\\n])*\"|'(?:\\.|[^'\\\n])*'"
+
+
+def minify_css(text):
+    # Conservative: quoted strings are copied untouched, and whitespace is only
+    # dropped next to { } ; , where it never carries meaning. Whitespace before
+    # ':' is a descendant combinator in selectors ("a :hover"), so it stays.
+    parts = re.split("(%s|/\\*.*?\\*/)" % CSS_STRING, text, flags=re.S)
+    text = "".join(p for p in parts if not p.startswith("/*"))
+
+    parts = re.split("(%s)" % CSS_STRING, text)
+    for i in range(0, len(parts), 2):  # even indices are outside strings
+        p = re.sub(r"\s+", " ", parts[i])
+        p = re.sub(r"\s*([{};,])\s*", r"\1", p)
+        parts[i] = p.replace(";}", "}")
+    return "".join(parts).strip()
+
+
+def minify_js(text):
+    # Line-based only: dropping indentation, blank lines and whole-line // comments
+    # is safe without a tokenizer (no ASI, string or regex literal pitfalls).
+    lines = (line.strip() for line in text.splitlines())
+    return "\n".join(l for l in lines if l and not l.startswith("//"))
+
+
+def minify_html(text):
+    text = re.sub(r"<!--(?!\[if).*?-->", "", text, flags=re.S)
+    lines = (line.strip() for line in text.splitlines())
+    return "\n".join(l for l in lines if l)
+
+
+MINIFIERS = {".css": minify_css, ".js": minify_js, ".html": minify_html, ".htm": minify_html}
+
+
+def content_hash(data):
+    return hashlib.sha256(data).hexdigest()[:HASH_LEN]
+
+
+def version_references(html, hashes):
+    # href="style.css" -> href="style.css?v=1a2b3c4d5e6f" for every asset we hashed
+    def repl(match):
+        attr, quote, ref = match.group(1), match.group(2), match.group(3)
+        key = "/" + ref.lstrip("/")
+        if key in hashes:
+            return '%s=%s%s?v=%s%s' % (attr, quote, ref, hashes[key], quote)
+        return match.group(0)
+
+    return re.sub(r'\b(href|src)=(["\'])([^"\'?#:]+)\2', repl, html)
+
+
+def collect_sources(src_dir):
+    assets = {}
+    for root, _, files in os.walk(src_dir):
+        for name in sorted(files):
+            full = os.path.join(root, name)
+            url = "/" + os.path.relpath(full, src_dir).replace(os.sep, "/")
+            with open(full, "rb") as f:
+                data = f.read()
+            ext = os.path.splitext(name)[1].lower()
+            if ext in MINIFIERS:
+                data = MINIFIERS[ext](data.decode("utf-8")).encode("utf-8")
+            assets[url] = data
+    return assets
+
+
+def build(project_dir):
+    src_dir = os.path.join(project_dir, SRC_DIR)
+    out_dir = os.path.join(project_dir, OUT_DIR)
+    shutil.rmtree(out_dir, ignore_errors=True)
+    os.makedirs(out_dir)
+
+    assets = collect_sources(src_dir) if os.path.isdir(src_dir) else {}
+
+    # Pages are always revalidated, so only links to non-HTML assets get versioned.
+    hashes = {url: content_hash(data) for url, data in assets.items() if not url.endswith((".html", ".htm"))}
+    static_hashes = dict(hashes)
+    for url, data in assets.items():
+        if url.endswith((".html", ".htm")):
+            data = version_references(data.decode("utf-8"), static_hashes).encode("utf-8")
+            assets[url] = data
+            hashes[url] = content_hash(data)
+
+    raw_total = gz_total = 0
+    manifest = []
+    for url in sorted(assets):
+        out_path = os.path.join(out_dir, url.lstrip("/") + ".gz")
+        os.makedirs(os.path.dirname(out_path), exist_ok=True)
+        with open(out_path, "wb") as f:
+            # mtime=0 keeps the output byte-identical across builds
+            with gzip.GzipFile(fileobj=f, mode="wb", compresslevel=9, mtime=0, filename="") as gz:
+                gz.write(assets[url])
+        raw_total += len(assets[url])
+        gz_total += os.path.getsize(out_path)
+        manifest.append("%s %s\n" % (url, hashes[url]))
+
+    # "\n" on every host: a CRLF manifest would put '\r' into the ETags.
+    with open(os.path.join(out_dir, MANIFEST), "w", newline="\n") as f:
+        f.writelines(manifest)
+
+    if assets:
+        print("[web-assets] %d assets: %d bytes minified -> %d bytes gzipped" % (len(assets), raw_total, gz_total))
+    else:
+        print("[web-assets] no sources in %s/; LittleFS image will only hold the manifest" % SRC_DIR)
+
+
+try:
+    Import("env")  # noqa: F821 — provided by PlatformIO/SCons
+    build(env.subst("$PROJECT_DIR"))  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        build(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
@@ -0,0 +1,77 @@
+#include "adc_filter_bench.h"
+
+#ifdef ADC_FILTER_BENCH
+
+#include <Arduino.h>
+#include "adc_filters.h"
+#include "deferred_log.h"
+
+static constexpr int BENCH_BURST   = 20;
+static constexpr int BENCH_BURSTS  = 256;
+static constexpr int SPIKE_EVERY   = 8;    // one burst in 8 carries an outlier read
+
+// Synthetic suspension signal: a slow ramp with ~6-count noise (sum of four
+// uniforms) and occasional full-scale spikes, mimicking the ESP32-S3 ADC.
+struct BenchData {
+    int samples[BENCH_BURSTS][BENCH_BURST];
+    int truth[BENCH_BURSTS];
+};
+
+static uint32_t lcgState = 12345;
+static int lcgNext(int range) {
+    lcgState = lcgState * 1664525u + 1013904223u;
+    return (int)((lcgState >> 8) % (uint32_t)range);
+}
+
+static void generateBenchData(BenchData& data) {
+    for (int b = 0; b < BENCH_BURSTS; b++) {
+        int truth = 500 + b * 12;
+        data.truth[b] = truth;
+        for (int i = 0; i < BENCH_BURST; i++) {
+            int noise = lcgNext(11) + lcgNext(11) + lcgNext(11) + lcgNext(11) - 20;
+            data.samples[b][i] = constrain(truth + noise, 0, 4095);
+        }
+        if (b % SPIKE_EVERY == 0) data.samples[b][lcgNext(BENCH_BURST)] = lcgNext(2) ? 4095 : 0;
+    }
+}
+
+template <typename Filter>
+static void benchFilter(const char* name, const BenchData& data) {
+    static_assert(Filter::SAMPLES == BENCH_BURST, "Benchmark bursts are BENCH_BURST samples long");
+    Filter filter;
+    volatile int sink = 0;
+    uint32_t errSum = 0, errMax = 0;
+
+    uint32_t t0 = ESP.getCycleCount();
+    for (int b = 0; b < BENCH_BURSTS; b++) sink = filter.apply(data.samples[b]);
+    uint32_t cycles = ESP.getCycleCount() - t0;
+    (void)sink;
+
+    Filter fresh;
+    for (int b = 0; b < BENCH_BURSTS; b++) {
+        uint32_t err = abs(fresh.apply(data.samples[b]) - data.truth[b]);
+        errSum += err;
+        if (err > errMax) errMax = err;
+    }
+
+    LOG_INFO("[BENCH] %s: %u cycles/burst, %u cycles/sample, mean_err=%.2f max_err=%u counts",
+             name, (unsigned)(cycles / BENCH_BURSTS), (unsigned)(cycles / (BENCH_BURSTS * BENCH_BURST)),
+             errSum / (float)BENCH_BURSTS, (unsigned)errMax);
+}
+
+void runAdcFilterBenchmark() {
+    static BenchData data;
+    generateBenchData(data);
+
+    benchFilter<BurstMean<BENCH_BURST>>("mean", data);
+    benchFilter<SigmaGatedMean<BENCH_BURST, 2>>("sigma2", data);
+    benchFilter<MedianOfN<BENCH_BURST>>("median", data);
+    benchFilter<TrimmedMean<BENCH_BURST, 4>>("trim4", data);
+    benchFilter<Smoothed<SigmaGatedMean<BENCH_BURST, 2>, 2>>("sigma2+iir", data);
+}
+
+#else
+
+void runAdcFilterBenchmark() {}
+
+#endif
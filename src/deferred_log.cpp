@@ -0,0 +1,196 @@
+#include "deferred_log.h"
+#include "storage_manager.h"
+#include <atomic>
+
+static constexpr uint32_t LOG_TASK_PERIOD_MS = 20;
+static constexpr size_t   LOG_LINE_MAX       = 192;
+static constexpr size_t   LOG_BATCH_MAX      = 1024;
+
+static constexpr uint32_t LOG_RING_MASK = LOG_RING_SIZE - 1;
+
+// Each slot carries a sequence number saying whose turn it is. For the free-running
+// position p, with lap = p & ~LOG_RING_MASK:
+//   seq == lap      free for the producer that claims p
+//   seq == lap + 1  written, ready for the log task
+// The log task sets it to lap + LOG_RING_SIZE, the next lap's "free", once read.
+// Zero-initialised slots are therefore free for the first lap.
+struct LogSlot {
+    LogRecord rec;
+    std::atomic<uint32_t> seq{0};
+};
+
+// One ring per core. Producers (tasks or ISRs preempting each other on that core)
+// claim a slot with a compare-and-swap on head and publish it through its seq, so
+// a push never waits on a lock or masks interrupts. The log task is the only consumer.
+struct LogRing {
+    LogSlot slots[LOG_RING_SIZE];
+    std::atomic<uint32_t> head{0};     // free-running; next position producers claim
+    std::atomic<uint32_t> tail{0};     // free-running; next position the log task reads
+    std::atomic<uint32_t> dropped{0};
+};
+
+static LogRing logRings[2];
+
+void logPush(uint8_t level, const char* fmt, const uint32_t* args, uint8_t argCount) {
+    LogRing& ring = logRings[xPortGetCoreID() & 1];
+    uint32_t now = micros();
+
+    uint32_t pos = ring.head.load(std::memory_order_relaxed);
+    LogSlot* slot;
+    while (true) {
+        slot = &ring.slots[pos & LOG_RING_MASK];
+        int32_t turn = (int32_t)(slot->seq.load(std::memory_order_acquire) - (pos & ~LOG_RING_MASK));
+        if (turn == 0) {
+            // On failure pos is reloaded with the head another producer moved on.
+            if (ring.head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (turn < 0) {
+            // Still holds last lap's record: the ring is full.
+            ring.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = ring.head.load(std::memory_order_relaxed);
+        }
+    }
+
+    LogRecord& rec = slot->rec;
+    rec.fmt         = fmt;
+    rec.timestampUs = now;
+    rec.level       = level;
+    rec.argCount    = argCount;
+    memcpy(rec.args, args, argCount * sizeof(uint32_t));
+    slot->seq.store((pos & ~LOG_RING_MASK) + 1, std::memory_order_release);
+}
+
+uint32_t logDroppedCount() {
+    return logRings[0].dropped.load() + logRings[1].dropped.load();
+}
+
+// ─── Formatting (log task only) ──────────────────────────────────────────────
+
+// Formats one conversion spec with its 32-bit argument; the conversion letter
+// decides how the bits are reinterpreted.
+static int formatArg(char* out, size_t room, const char* spec, char conv, uint32_t raw) {
+    switch (conv) {
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': {
+            float f;
+            memcpy(&f, &raw, sizeof(f));
+            return snprintf(out, room, spec, (double)f);
+        }
+        case 's': return snprintf(out, room, spec, raw ? (const char*)(uintptr_t)raw : "(null)");
+        case 'p': return snprintf(out, room, spec, (void*)(uintptr_t)raw);
+        case 'c': case 'd': case 'i': return snprintf(out, room, spec, (int)raw);
+        default:  return snprintf(out, room, spec, (unsigned)raw);
+    }
+}
+
+// Writes the record as one '\n'-terminated line, truncated to cap bytes.
+static size_t formatRecord(const LogRecord& rec, char* out, size_t cap) {
+    size_t n = 0;
+    size_t limit = cap - 1;  // room for the newline
+    uint8_t argIdx = 0;
+    const char* p = rec.fmt;
+
+    while (*p && n < limit) {
+        if (*p != '%') { out[n++] = *p++; continue; }
+        if (p[1] == '%') { out[n++] = '%'; p += 2; continue; }
+
+        char spec[16];
+        size_t s = 0;
+        spec[s++] = *p++;
+        while (*p && strchr("-+ #0123456789.", *p) && s < sizeof(spec) - 2) spec[s++] = *p++;
+        while (*p && strchr("hlzjt", *p)) p++;
+        if (!*p) break;
+        char conv = *p++;
+        spec[s++] = conv;
+        spec[s]   = '\0';
+
+        uint32_t raw = argIdx < rec.argCount ? rec.args[argIdx++] : 0;
+        int written = formatArg(out + n, limit - n + 1, spec, conv, raw);
+        if (written < 0) break;
+        n += (size_t)written < limit - n ? (size_t)written : limit - n;
+    }
+
+    out[n++] = '\n';
+    return n;
+}
+
+// ─── Log task ────────────────────────────────────────────────────────────────
+
+static void emitBatch(const char* data, size_t len) {
+    Serial.write((const uint8_t*)data, len);
+    if (LOG_SINK_SD) appendSystemLog(data, len);
+}
+
+// The record at the ring's tail if its producer has published it. A producer
+// preempted between claiming and publishing just holds up its own ring until the
+// next pass.
+static LogSlot* readySlot(LogRing& ring) {
+    uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+    LogSlot& slot = ring.slots[tail & LOG_RING_MASK];
+    if (slot.seq.load(std::memory_order_acquire) != (tail & ~LOG_RING_MASK) + 1) return nullptr;
+    return &slot;
+}
+
+// Oldest pending record across both rings, so output stays in time order.
+static LogRing* oldestPendingRing() {
+    LogRing* oldest = nullptr;
+    uint32_t oldestUs = 0;
+    for (LogRing& ring : logRings) {
+        LogSlot* slot = readySlot(ring);
+        if (!slot) continue;
+
+        uint32_t ts = slot->rec.timestampUs;
+        if (!oldest || (int32_t)(ts - oldestUs) < 0) {
+            oldest   = &ring;
+            oldestUs = ts;
+        }
+    }
+    return oldest;
+}
+
+static void drainLogs() {
+    static char batch[LOG_BATCH_MAX];
+    size_t used = 0;
+
+    while (LogRing* ring = oldestPendingRing()) {
+        uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+        LogSlot& slot = ring->slots[tail & LOG_RING_MASK];
+        LogRecord rec = slot.rec;
+        slot.seq.store((tail & ~LOG_RING_MASK) + LOG_RING_SIZE, std::memory_order_release);
+        ring->tail.store(tail + 1, std::memory_order_relaxed);
+
+        if (used + LOG_LINE_MAX > LOG_BATCH_MAX) {
+            emitBatch(batch, used);
+            used = 0;
+        }
+        used += formatRecord(rec, batch + used, LOG_LINE_MAX);
+    }
+
+    if (used > 0) emitBatch(batch, used);
+}
+
+static void reportDrops(uint32_t& lastReported) {
+    uint32_t dropped = logDroppedCount();
+    if (dropped == lastReported) return;
+
+    char line[64];
+    int len = snprintf(line, sizeof(line), "[LOG] %u records dropped (ring full)\n", (unsigned)(dropped - lastReported));
+    emitBatch(line, (size_t)len);
+    lastReported = dropped;
+}
+
+static void LogTaskcode(void* pvParameter) {
+    uint32_t lastReported = 0;
+
+    while (true) {
+        drainLogs();
+        reportDrops(lastReported);
+        vTaskDelay(pdMS_TO_TICKS(LOG_TASK_PERIOD_MS));
+    }
+}
+
+// Same priority as WiFiTask: anything lower would starve behind Arduino's
+// loopTask, which spins on core 1 at priority 1.
+void startLogTask() {
+    xTaskCreatePinnedToCore(LogTaskcode, "LogTask", 4096, NULL, 1, NULL, 1); // Core 1
+}
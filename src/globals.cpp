@@ -9,6 +9,8 @@ Adafruit_NeoPixel neopixel(NEOPIXEL_COUNT, NEOPIXEL_PIN, NEO_GRB + NEO_KHZ800);
 Adafruit_MAX17048 maxlipo;
 volatile int batteryPercent = -1;
 volatile int recording = 0; // 0 = not recording, 1 = setup, 2 = recording
+volatile uint32_t activeSampleRateHz    = DEFAULT_SAMPLE_RATE_HZ;
+volatile uint32_t requestedSampleRateHz = DEFAULT_SAMPLE_RATE_HZ;
 
 String currentRunFilePath = "";
 
@@ -1,4 +1,5 @@
 #include "imu_handler.h"
+#include "deferred_log.h"
 #include <Wire.h>
 
 static constexpr int   CAL_SAMPLES         = 50;
@@ -6,6 +7,14 @@ static constexpr int   CAL_SAMPLE_DELAY_MS = 10;
 static constexpr float GRAVITY_FAULT_THRESHOLD = 0.5f;
 static constexpr float GRAVITY_FALLBACK    = 9.806f;
 
+// Zero-motion detection. A window is still when every axis is quiet and the mean
+// acceleration is ~1 g; thresholds sit a few times above the LSM6DS3 noise floor.
+static constexpr float STILL_GYRO_VAR_MAX   = 4e-4f;   // (0.02 rad/s)^2 per axis
+static constexpr float STILL_ACCEL_VAR_MAX  = 4e-3f;   // (0.063 m/s2)^2 per axis
+static constexpr float STILL_GYRO_MEAN_MAX  = 0.1f;    // rad/s; anything larger is rotation, not bias
+static constexpr float STILL_GRAVITY_TOL    = 0.5f;    // m/s2 from GRAVITY_FALLBACK
+static constexpr float BIAS_TRACK_ALPHA     = 0.25f;   // weight of each new still window
+
 void initImu(ImuState& imu) {
     Wire.begin();
     Wire.setClock(400000);  // 400 kHz fast mode — must be after Wire.begin()
@@ -13,14 +22,28 @@ void initImu(ImuState& imu) {
     imu.ok = imu.device.begin_I2C();
 
     if (!imu.ok) {
-        Serial.println("[IMU] not found — will record with zero IMU values");
+        LOG_WARN("[IMU] not found — will record with zero IMU values");
         return;
     }
 
-    imu.device.setAccelDataRate(LSM6DS_RATE_104_HZ);
     imu.device.setAccelRange(LSM6DS_ACCEL_RANGE_4_G);
-    imu.device.setGyroDataRate(LSM6DS_RATE_104_HZ);
     imu.device.setGyroRange(LSM6DS_GYRO_RANGE_2000_DPS);
+    setImuSampleRate(imu, DEFAULT_SAMPLE_RATE_HZ);
+}
+
+// Picks the slowest output data rate that still gives a fresh reading every
+// sample, and rescales the still-detection window to keep it 0.5 s long.
+void setImuSampleRate(ImuState& imu, uint32_t rateHz) {
+    imu.stillWindowSamples = rateHz / 2 > 0 ? rateHz / 2 : 1;
+    imu.still = StillWindow{};
+    if (!imu.ok) return;
+
+    lsm6ds_data_rate_t odr = rateHz <= 104 ? LSM6DS_RATE_104_HZ
+                           : rateHz <= 208 ? LSM6DS_RATE_208_HZ
+                           : rateHz <= 416 ? LSM6DS_RATE_416_HZ
+                           :                 LSM6DS_RATE_833_HZ;
+    imu.device.setAccelDataRate(odr);
+    imu.device.setGyroDataRate(odr);
 }
 
 static void collectCalibrationSamples(ImuState& imu,
@@ -52,10 +75,10 @@ static void computeBiasesFromSums(ImuState& imu,
     imu.accelBias[1] = (float)(sumAY / CAL_SAMPLES);
     imu.accelBias[2] = (float)(sumAZ / CAL_SAMPLES);
 
-    Serial.printf("[CAL] gyro  bias x=%.4f y=%.4f z=%.4f rad/s\n",
-                  imu.gyroBias[0], imu.gyroBias[1], imu.gyroBias[2]);
-    Serial.printf("[CAL] accel bias x=%.4f y=%.4f z=%.4f m/s2\n",
-                  imu.accelBias[0], imu.accelBias[1], imu.accelBias[2]);
+    LOG_INFO("[CAL] gyro  bias x=%.4f y=%.4f z=%.4f rad/s",
+             imu.gyroBias[0], imu.gyroBias[1], imu.gyroBias[2]);
+    LOG_INFO("[CAL] accel bias x=%.4f y=%.4f z=%.4f m/s2",
+             imu.accelBias[0], imu.accelBias[1], imu.accelBias[2]);
 }
 
 static void resetRotationMatrixToIdentity(ImuState& imu) {
@@ -64,7 +87,7 @@ static void resetRotationMatrixToIdentity(ImuState& imu) {
     imu.R[0][0]=1; imu.R[0][1]=0; imu.R[0][2]=0;
     imu.R[1][0]=0; imu.R[1][1]=1; imu.R[1][2]=0;
     imu.R[2][0]=0; imu.R[2][1]=0; imu.R[2][2]=1;
-    Serial.printf("[CAL] ERROR gravMag=%.3f — sensor fault? R reset to identity\n", badGravMag);
+    LOG_ERROR("[CAL] ERROR gravMag=%.3f — sensor fault? R reset to identity", badGravMag);
 }
 
 static void buildRotationMatrix(ImuState& imu) {
@@ -99,17 +122,19 @@ static void buildRotationMatrix(ImuState& imu) {
     imu.R[0][0]=wx[0]; imu.R[0][1]=wx[1]; imu.R[0][2]=wx[2];
     imu.R[1][0]=wy[0]; imu.R[1][1]=wy[1]; imu.R[1][2]=wy[2];
     imu.R[2][0]=wz[0]; imu.R[2][1]=wz[1]; imu.R[2][2]=wz[2];
+}
 
-    Serial.printf("[CAL] gravMag=%.3f R=[[%.3f,%.3f,%.3f],[%.3f,%.3f,%.3f],[%.3f,%.3f,%.3f]]\n",
-                  imu.gravMag,
-                  imu.R[0][0], imu.R[0][1], imu.R[0][2],
-                  imu.R[1][0], imu.R[1][1], imu.R[1][2],
-                  imu.R[2][0], imu.R[2][1], imu.R[2][2]);
+static void logRotationMatrix(const ImuState& imu) {
+    LOG_INFO("[CAL] gravMag=%.3f R=[[%.3f,%.3f,%.3f],[%.3f,%.3f,%.3f],[%.3f,%.3f,%.3f]]",
+             imu.gravMag,
+             imu.R[0][0], imu.R[0][1], imu.R[0][2],
+             imu.R[1][0], imu.R[1][1], imu.R[1][2],
+             imu.R[2][0], imu.R[2][1], imu.R[2][2]);
 }
 
 void calibrateImu(ImuState& imu) {
     if (!imu.ok) {
-        Serial.println("[CAL] IMU not found — recording with zero gyro bias");
+        LOG_WARN("[CAL] IMU not found — recording with zero gyro bias");
         return;
     }
 
@@ -119,6 +144,78 @@ void calibrateImu(ImuState& imu) {
     collectCalibrationSamples(imu, sumGX, sumGY, sumGZ, sumAX, sumAY, sumAZ);
     computeBiasesFromSums(imu, sumGX, sumGY, sumGZ, sumAX, sumAY, sumAZ);
     buildRotationMatrix(imu);
+    logRotationMatrix(imu);
+
+    imu.biasValid   = true;
+    imu.biasUpdated = true;
+    imu.still       = StillWindow{};
+}
+
+// ─── Background bias tracking ────────────────────────────────────────────────
+
+static bool windowIsStill(const StillWindow& w, float meanG[3], float meanA[3]) {
+    float n = (float)w.count;
+    float gyroMeanSq = 0, accelMeanSq = 0;
+
+    for (int i = 0; i < 3; i++) {
+        float dG = w.sumG[i] / n;
+        float dA = w.sumA[i] / n;
+        if (w.sumG2[i] / n - dG * dG > STILL_GYRO_VAR_MAX)  return false;
+        if (w.sumA2[i] / n - dA * dA > STILL_ACCEL_VAR_MAX) return false;
+
+        meanG[i] = w.refG[i] + dG;
+        meanA[i] = w.refA[i] + dA;
+        gyroMeanSq  += meanG[i] * meanG[i];
+        accelMeanSq += meanA[i] * meanA[i];
+    }
+
+    if (gyroMeanSq > STILL_GYRO_MEAN_MAX * STILL_GYRO_MEAN_MAX) return false;
+    return fabsf(sqrtf(accelMeanSq) - GRAVITY_FALLBACK) <= STILL_GRAVITY_TOL;
+}
+
+// The first still window since boot replaces the defaults outright; later ones are
+// blended in so a single marginal window cannot yank the world frame.
+static void applyStillWindow(ImuState& imu, const float meanG[3], const float meanA[3]) {
+    float alpha = imu.biasValid ? BIAS_TRACK_ALPHA : 1.0f;
+    for (int i = 0; i < 3; i++) {
+        imu.gyroBias[i]  += alpha * (meanG[i] - imu.gyroBias[i]);
+        imu.accelBias[i] += alpha * (meanA[i] - imu.accelBias[i]);
+    }
+    buildRotationMatrix(imu);
+
+    imu.biasValid   = true;
+    imu.biasUpdated = true;
+}
+
+static void feedStillWindow(ImuState& imu, const sensors_event_t& accel, const sensors_event_t& gyro) {
+    StillWindow& w = imu.still;
+    const float g[3] = { gyro.gyro.x, gyro.gyro.y, gyro.gyro.z };
+    const float a[3] = { accel.acceleration.x, accel.acceleration.y, accel.acceleration.z };
+
+    if (w.count == 0) {
+        for (int i = 0; i < 3; i++) { w.refG[i] = g[i]; w.refA[i] = a[i]; }
+    }
+    for (int i = 0; i < 3; i++) {
+        float dG = g[i] - w.refG[i];
+        float dA = a[i] - w.refA[i];
+        w.sumG[i] += dG;  w.sumG2[i] += dG * dG;
+        w.sumA[i] += dA;  w.sumA2[i] += dA * dA;
+    }
+    if (++w.count < imu.stillWindowSamples) return;
+
+    float meanG[3], meanA[3];
+    if (windowIsStill(w, meanG, meanA)) applyStillWindow(imu, meanG, meanA);
+    w = StillWindow{};
+}
+
+// Idle-time reading used only to keep the bias estimate fresh between runs.
+void trackImuBias(ImuState& imu) {
+    if (!imu.ok) return;
+
+    sensors_event_t accel, gyro, temp;
+    if (imu.device.getEvent(&accel, &gyro, &temp)) {
+        feedStillWindow(imu, accel, gyro);
+    }
 }
 
 void populateImuReadingIntoLine(ImuState& imu, SensorLine& line) {
@@ -151,4 +248,8 @@ void populateImuReadingIntoLine(ImuState& imu, SensorLine& line) {
     line.acc[3] = (int)((imu.R[0][0]*ax + imu.R[0][1]*ay + imu.R[0][2]*az) / imu.gravMag * 1000.0f);
     line.acc[4] = (int)((imu.R[1][0]*ax + imu.R[1][1]*ay + imu.R[1][2]*az) / imu.gravMag * 1000.0f);
     line.acc[5] = (int)((imu.R[2][0]*ax + imu.R[2][1]*ay + imu.R[2][2]*az - imu.gravMag) / imu.gravMag * 1000.0f);
+
+    // Fed after the line is computed: an update from the window this reading
+    // completes applies from the next sample, the one handleBiasUpdate() stamps.
+    feedStillWindow(imu, accel, gyro);
 }
@@ -2,7 +2,10 @@
 #include "globals.h"
 #include "storage_manager.h"
 #include "network_manager.h"
+#include "web_assets.h"
 #include "telemetry_tasks.h"
+#include "deferred_log.h"
+#include "adc_filter_bench.h"
 
 void setup() {
     Serial.begin(115200);
@@ -11,6 +14,7 @@ void setup() {
     while (!Serial && (millis() - start < 4000)) {
         delay(10);
     }
+    startLogTask();
 
     WiFi.setTxPower(WIFI_POWER_8_5dBm); // Set WiFi transmit power to 8.5 dBm
 
@@ -28,24 +32,29 @@ void setup() {
 
     // Initialise MAX17048 fuel gauge (I2C, address 0x36)
     if (!maxlipo.begin()) {
-        Serial.println("[BATT] MAX17048 not found — battery % unavailable");
+        LOG_WARN("[BATT] MAX17048 not found — battery %% unavailable");
     } else {
-        Serial.println("[BATT] MAX17048 found");
+        LOG_INFO("[BATT] MAX17048 found");
     }
 
     setLedColor(255, 255, 255); // Loading state — white
 
-    if (!initStorage()) {
-        Serial.println("Storage Critical Failure");
-        setLedColor(0, 0, 255); // blue — critical failure
-        return;
+    // A missing card is no longer fatal: the mount manager in WiFiTask keeps
+    // retrying with backoff and runs can be armed once it comes back.
+    bool storageOk = initStorage();
+    if (!storageOk) {
+        LOG_ERROR("[SD] mount failed at boot — retrying in background");
     }
 
+    initWebAssets();
+    runAdcFilterBenchmark();  // no-op unless built with -D ADC_FILTER_BENCH
+
     // Launch Tasks
     xTaskCreatePinnedToCore(WiFiTaskcode, "WiFiTask", 12000, NULL, 1, NULL, 1); // Core 1
     xTaskCreatePinnedToCore(DataTaskcode, "DataTask", 10000, NULL, 1, NULL, 0); // Core 0
 
-    setLedColor(0, 255, 0); // green — ready
+    if (storageOk) setLedColor(0, 255, 0); // green — ready
+    else           setLedColor(0, 0, 255); // blue — no SD card yet
 }
 
 void loop() {
@@ -1,16 +1,115 @@
 #include "network_manager.h"
 #include "globals.h"
 #include "config.h"
+#include "storage_manager.h"
+#include "summary_pyramid.h"
+#include "sd_mount.h"
+#include "web_assets.h"
 #include <WiFi.h>
 #include <ArduinoJson.h>
 #include <SD.h>
 
+struct ByteRange {
+    size_t offset;
+    size_t length;
+};
+
+// Handlers wait this long for a flush to release the card before answering 503.
+static constexpr TickType_t SD_HANDLER_WAIT = pdMS_TO_TICKS(500);
+
+// Takes the SD I/O lock for a handler, or answers 503 and returns false.
+static bool lockSdOrFail(AsyncWebServerRequest* request, bool json = false) {
+    if (lockSdIo(SD_HANDLER_WAIT)) return true;
+
+    const char* reason = sdMounted() ? "SD Card busy" : "SD Card not mounted";
+    if (json) request->send(503, "application/json", String("{\"error\":\"") + reason + "\"}");
+    else      request->send(503, "text/plain", reason);
+    return false;
+}
+
+// Streams `head` then `body` of one SD file back to back without holding either in RAM.
+// Each chunk is read under the SD I/O lock; build the response after unlocking,
+// since dropping the last reference to the stream takes the lock to close it.
+static AsyncWebServerResponse* beginFileRangeResponse(AsyncWebServerRequest* request, std::shared_ptr<SdStream> stream,
+                                                      const char* contentType, ByteRange head, ByteRange body) {
+    return request->beginResponse(contentType, head.length + body.length,
+        [stream, head, body](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            bool inHead = index < head.length;
+            const ByteRange& range = inHead ? head : body;
+            size_t rel = inHead ? index : index - head.length;
+            if (rel >= range.length || !stream->open) return 0;
+
+            if (!lockSdIo(0)) {
+                if (sdMounted()) return RESPONSE_TRY_AGAIN;  // a flush holds the card
+                closeSdStream(*stream);                      // card lost: let the unmount go ahead
+                return 0;
+            }
+            size_t toRead = range.length - rel < maxLen ? range.length - rel : maxLen;
+            size_t n = stream->file.seek(range.offset + rel) ? stream->file.read(buffer, toRead) : 0;
+            unlockSdIo();
+            return n;
+        });
+}
+
+static bool readSeekEntry(File& index, uint32_t entry, uint32_t& offset) {
+    if (!index.seek(entry * sizeof(uint32_t))) return false;
+    return index.read((uint8_t*)&offset, sizeof(offset)) == sizeof(offset);
+}
+
+// Streams the header and calibration lines followed by the rows covering
+// [fromMs, toMs], widened outwards to seek-index boundaries. Costs two index
+// reads and one seek into the CSV regardless of run length. Called with the SD
+// I/O lock held; releases it.
+static void sendRunWindow(AsyncWebServerRequest* request, const String& path, uint32_t fromMs, uint32_t toMs) {
+    File index = SD.open(seekIndexPath(path).c_str(), FILE_READ);
+    if (!index) {
+        unlockSdIo();
+        request->send(404, "text/plain", "No seek index for this run");
+        return;
+    }
+    auto csv = openSdStream(path);
+    if (!csv) {
+        index.close();
+        unlockSdIo();
+        request->send(404, "text/plain", "Not found");
+        return;
+    }
+    uint32_t csvSize = csv->file.size();
+
+    // Entries are SEEK_INDEX_INTERVAL samples apart, which need not be a whole
+    // number of milliseconds at the run's rate, so convert via sample numbers.
+    uint64_t rateHz  = readRunSampleRate(path);
+    uint32_t entries = index.size() / sizeof(uint32_t);
+    uint32_t firstEntry = (uint32_t)(fromMs * rateHz / 1000 / SEEK_INDEX_INTERVAL);
+    uint32_t endEntry   = (uint32_t)((uint64_t)toMs * rateHz / 1000 / SEEK_INDEX_INTERVAL + 1);  // exclusive; includes the sample at toMs
+
+    uint32_t headerLen = csvSize, start = csvSize, end = csvSize;
+    readSeekEntry(index, 0, headerLen);
+    if (firstEntry < entries) readSeekEntry(index, firstEntry, start);
+    if (endEntry < entries)   readSeekEntry(index, endEntry, end);
+    index.close();
+    unlockSdIo();
+    if (end < start) end = start;
+
+    AsyncWebServerResponse* response = beginFileRangeResponse(request, csv, "text/csv",
+                                                              { 0, headerLen }, { start, end - start });
+    response->addHeader("X-Window-Start-Ms", String((uint32_t)((uint64_t)firstEntry * SEEK_INDEX_INTERVAL * 1000 / rateHz)));
+    response->addHeader("X-Sample-Rate-Hz", String((uint32_t)rateHz));
+    request->send(response);
+}
+
+// Picks the coarsest pyramid level whose buckets are no wider than the requested resolution.
+static int pyramidLevelForResolution(uint32_t resMs) {
+    int level = 0;
+    for (int l = 1; l < PYRAMID_LEVELS; l++) {
+        if (PYRAMID_LEVEL_MS[l] <= resMs) level = l;
+    }
+    return level;
+}
+
 void setupWebRoutes() {
     server.on("/runs", HTTP_GET, [](AsyncWebServerRequest *request) {
-        if (!SD.begin(SD_CS_PIN)) {
-            request->send(500, "application/json", "{\"error\":\"SD Card mount failed\"}");
-            return;
-        }
+        if (!lockSdOrFail(request, true)) return;
 
         JsonDocument doc;
         JsonArray runsArray = doc.to<JsonArray>();
@@ -32,6 +131,7 @@ void setupWebRoutes() {
         }
 
         root.close();
+        unlockSdIo();
 
         String json;
         serializeJson(doc, json);
@@ -43,12 +143,69 @@ void setupWebRoutes() {
             request->send(400, "text/plain", "Missing name");
             return;
         }
+        if (!lockSdOrFail(request)) return;
         String path = "/" + request->getParam("name")->value();
         if (!SD.exists(path)) {
+            unlockSdIo();
+            request->send(404, "text/plain", "Not found");
+            return;
+        }
+
+        // GET /file?name=run_N.csv[&from=ms][&to=ms] — a time window streams only its rows.
+        if (request->hasParam("from") || request->hasParam("to")) {
+            uint32_t fromMs = request->hasParam("from") ? request->getParam("from")->value().toInt() : 0;
+            uint32_t toMs   = request->hasParam("to")   ? request->getParam("to")->value().toInt()   : UINT32_MAX;
+            sendRunWindow(request, path, fromMs, toMs);
+            return;
+        }
+
+        auto csv = openSdStream(path);
+        size_t size = csv ? csv->file.size() : 0;
+        unlockSdIo();
+        if (!csv) {
             request->send(404, "text/plain", "Not found");
             return;
         }
-        request->send(SD, path, "text/csv");
+        request->send(beginFileRangeResponse(request, csv, "text/csv", { 0, 0 }, { 0, size }));
+    });
+
+    // GET /summary?name=run_N.csv[&from=ms][&to=ms][&res=ms]
+    // Returns raw PyramidRecord structs (little-endian int32 min[8], max[8], mean[8])
+    // for the requested window; X-Bucket-Ms and X-First-Bucket locate them in time.
+    server.on("/summary", HTTP_GET, [](AsyncWebServerRequest *request) {
+        if (!request->hasParam("name")) {
+            request->send(400, "text/plain", "Missing name");
+            return;
+        }
+        uint32_t resMs  = request->hasParam("res")  ? request->getParam("res")->value().toInt()  : PYRAMID_LEVEL_MS[PYRAMID_LEVELS - 1];
+        uint32_t fromMs = request->hasParam("from") ? request->getParam("from")->value().toInt() : 0;
+        uint32_t toMs   = request->hasParam("to")   ? request->getParam("to")->value().toInt()   : UINT32_MAX;
+
+        if (!lockSdOrFail(request)) return;
+        int level = pyramidLevelForResolution(resMs);
+        String path = summaryPath("/" + request->getParam("name")->value(), level);
+        auto summary = SD.exists(path) ? openSdStream(path) : nullptr;
+        uint32_t total = summary ? summary->file.size() / sizeof(PyramidRecord) : 0;
+        unlockSdIo();
+        if (!summary) {
+            request->send(404, "text/plain", "Not found");
+            return;
+        }
+
+        uint32_t bucketMs = PYRAMID_LEVEL_MS[level];
+        uint32_t first = fromMs / bucketMs;
+        uint64_t end   = ((uint64_t)toMs + bucketMs - 1) / bucketMs;  // 64-bit: `to` near UINT32_MAX must not wrap
+        uint32_t last  = end > total ? total : (uint32_t)end;
+        if (first > last) first = last;
+
+        AsyncWebServerResponse* response = beginFileRangeResponse(request, summary, "application/octet-stream",
+                                                                  { 0, 0 },
+                                                                  { first * sizeof(PyramidRecord),
+                                                                    (last - first) * sizeof(PyramidRecord) });
+        response->addHeader("X-Bucket-Ms", String(bucketMs));
+        response->addHeader("X-First-Bucket", String(first));
+        response->addHeader("X-Channels", String(PYRAMID_CHANNELS));
+        request->send(response);
     });
 
     server.on("/deleteRun", HTTP_POST, [](AsyncWebServerRequest *request) {
@@ -56,12 +213,15 @@ void setupWebRoutes() {
             String runName = request->hasParam("run", true)
                 ? request->getParam("run", true)->value()
                 : request->getParam("run")->value();
-            if (!SD.begin(SD_CS_PIN)) {
-                request->send(500, "text/plain", "SD Card mount failed");
-                return;
-            }
-            if (SD.exists("/" + runName)) {
+            if (!lockSdOrFail(request)) return;
+            bool found = SD.exists("/" + runName);
+            if (found) {
                 SD.remove("/" + runName);
+                removeRunSidecars("/" + runName);
+            }
+            unlockSdIo();
+
+            if (found) {
                 Serial.println("Deleted run: " + runName);
                 request->send(200, "text/plain", "Run deleted");
             } else {
@@ -77,6 +237,42 @@ void setupWebRoutes() {
         request->send(200, "application/json", json);
     });
 
+    server.on("/storage", HTTP_GET, [](AsyncWebServerRequest *request) {
+        String json = "{\"state\":\"" + String(sdStateName(sdMount.state.load())) + "\""
+                    + ",\"mounts\":" + String(sdMount.mountCount)
+                    + ",\"losses\":" + String(sdMount.lostCount) + "}";
+        request->send(200, "application/json", json);
+    });
+
+    // GET reports the rate of the current/last run and the one the next run will use;
+    // POST hz=N changes the latter. DataTask picks it up when the next run is armed.
+    server.on("/sampleRate", HTTP_GET, [](AsyncWebServerRequest *request) {
+        String json = "{\"active\":" + String(activeSampleRateHz)
+                    + ",\"requested\":" + String(requestedSampleRateHz)
+                    + ",\"min\":" + String(MIN_SAMPLE_RATE_HZ)
+                    + ",\"max\":" + String(MAX_SAMPLE_RATE_HZ) + "}";
+        request->send(200, "application/json", json);
+    });
+
+    server.on("/sampleRate", HTTP_POST, [](AsyncWebServerRequest *request) {
+        if (!request->hasParam("hz", true) && !request->hasParam("hz")) {
+            request->send(400, "text/plain", "Missing 'hz' parameter");
+            return;
+        }
+        long hz = request->hasParam("hz", true)
+            ? request->getParam("hz", true)->value().toInt()
+            : request->getParam("hz")->value().toInt();
+        if (hz < (long)MIN_SAMPLE_RATE_HZ || hz > (long)MAX_SAMPLE_RATE_HZ) {
+            request->send(400, "text/plain", "hz must be between " + String(MIN_SAMPLE_RATE_HZ)
+                                             + " and " + String(MAX_SAMPLE_RATE_HZ));
+            return;
+        }
+        requestedSampleRateHz = (uint32_t)hz;
+        request->send(200, "text/plain", "Sample rate for next run: " + String(hz) + " Hz");
+    });
+
+    setupAssetRoutes();
+
     server.onNotFound([](AsyncWebServerRequest *request) {
         request->send(404, "text/plain", "Not found");
     });
@@ -0,0 +1,43 @@
+#include "pretrigger_buffer.h"
+#include "globals.h"
+
+PretriggerRing pretriggerRing;
+
+void resetPretrigger() {
+    size_t depth = PRETRIGGER_MS * activeSampleRateHz / 1000;
+    pretriggerRing.depth  = depth < PRETRIGGER_MAX_SAMPLES ? depth : PRETRIGGER_MAX_SAMPLES;
+    pretriggerRing.head   = 0;
+    pretriggerRing.count  = 0;
+    pretriggerRing.drained = 0;
+    pretriggerRing.pushed = 0;
+    pretriggerRing.frozen = false;
+}
+
+void pushPretriggerSample(const SensorLine& line) {
+    if (pretriggerRing.frozen) return;
+
+    pretriggerRing.lines[pretriggerRing.head] = line;
+    pretriggerRing.head = (pretriggerRing.head + 1) % pretriggerRing.depth;
+    if (pretriggerRing.count < pretriggerRing.depth) pretriggerRing.count++;
+    pretriggerRing.pushed++;
+}
+
+// Freezing is O(1): the history is only copied out by the flushes that follow,
+// so the sample that fires the trigger still meets its deadline.
+void freezePretrigger() {
+    pretriggerRing.frozen = true;
+}
+
+bool hasPendingPretrigger() {
+    return pretriggerPending() > 0;
+}
+
+size_t pretriggerPending() {
+    return pretriggerRing.frozen ? pretriggerRing.count - pretriggerRing.drained : 0;
+}
+
+const SensorLine& pretriggerLineAt(size_t i) {
+    size_t depth  = pretriggerRing.depth;
+    size_t oldest = (pretriggerRing.head + depth - pretriggerRing.count) % depth;
+    return pretriggerRing.lines[(oldest + i) % depth];
+}
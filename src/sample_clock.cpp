@@ -0,0 +1,25 @@
+#include "sample_clock.h"
+
+void scheduleStart(SampleSchedule& s, uint32_t rateHz, int64_t nowUs) {
+    s.rateHz  = rateHz;
+    s.startUs = nowUs;
+    s.tick    = 1;
+    s.skipped = 0;
+}
+
+int64_t scheduleDeadlineUs(const SampleSchedule& s) {
+    return s.startUs + (int64_t)(s.tick * 1000000ULL / s.rateHz);
+}
+
+// Called when the armed deadline fires: moves to the first deadline after nowUs
+// and returns how many were skipped because the clock was serviced late.
+uint32_t scheduleAdvance(SampleSchedule& s, int64_t nowUs) {
+    uint32_t skipped = 0;
+    s.tick++;
+    while (scheduleDeadlineUs(s) <= nowUs) {
+        s.tick++;
+        skipped++;
+    }
+    s.skipped += skipped;
+    return skipped;
+}
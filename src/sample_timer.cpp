@@ -0,0 +1,80 @@
+#include "sample_timer.h"
+#include "sample_clock.h"
+#include "deferred_log.h"
+#include <esp_timer.h>
+
+static esp_timer_handle_t sampleTimer = NULL;
+static TaskHandle_t       sampleTask  = NULL;
+static SampleSchedule     schedule;
+static portMUX_TYPE       scheduleMux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t           maxBacklog  = 1;  // SAMPLE_MAX_CATCHUP_MS in ticks at the current rate
+static uint32_t           droppedTicks = 0;  // DataTask only
+
+// Runs in the esp_timer task: re-arm for the next absolute deadline first so the
+// cadence is independent of how long DataTask takes, then wake DataTask.
+static void onSampleTimer(void* arg) {
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&scheduleMux);
+    scheduleAdvance(schedule, now);
+    int64_t delayUs = scheduleDeadlineUs(schedule) - now;
+    portEXIT_CRITICAL(&scheduleMux);
+
+    esp_timer_start_once(sampleTimer, delayUs > 0 ? (uint64_t)delayUs : 1);
+    xTaskNotifyGive(sampleTask);
+}
+
+static void armSchedule(uint32_t rateHz) {
+    int64_t now = esp_timer_get_time();
+    uint32_t backlog = SAMPLE_MAX_CATCHUP_MS * rateHz / 1000;
+    maxBacklog   = backlog > 1 ? backlog : 1;
+    droppedTicks = 0;
+
+    portENTER_CRITICAL(&scheduleMux);
+    scheduleStart(schedule, rateHz, now);
+    int64_t delayUs = scheduleDeadlineUs(schedule) - now;
+    portEXIT_CRITICAL(&scheduleMux);
+
+    esp_timer_stop(sampleTimer);  // in case a callback re-armed it meanwhile
+    esp_timer_start_once(sampleTimer, (uint64_t)delayUs);
+}
+
+bool sampleTimerStart(TaskHandle_t task, uint32_t rateHz) {
+    sampleTask = task;
+
+    esp_timer_create_args_t args = {};
+    args.callback = onSampleTimer;
+    args.name     = "sample_clock";
+    if (esp_timer_create(&args, &sampleTimer) != ESP_OK) {
+        LOG_ERROR("[CLOCK] esp_timer_create failed");
+        return false;
+    }
+
+    armSchedule(rateHz);
+    LOG_INFO("[CLOCK] sampling at %u Hz", (unsigned)rateHz);
+    return true;
+}
+
+void sampleTimerSetRate(uint32_t rateHz) {
+    esp_timer_stop(sampleTimer);
+    ulTaskNotifyTake(pdTRUE, 0);  // discard ticks from the old schedule
+    armSchedule(rateHz);
+    LOG_INFO("[CLOCK] sampling at %u Hz", (unsigned)rateHz);
+}
+
+// Takes one tick at a time, so a loop that overran (e.g. a long SD flush) runs
+// back to back until it has caught up and every slot still gets its sample.
+// Only the part of a backlog older than SAMPLE_MAX_CATCHUP_MS is discarded, one
+// notification at a time, so the newest second is still worked off.
+uint32_t sampleTimerWait() {
+    uint32_t pending = ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+    while (pending > maxBacklog && ulTaskNotifyTake(pdFALSE, 0) > 0) {
+        droppedTicks++;
+        pending--;
+    }
+    return pending;
+}
+
+uint32_t sampleTimerSkipped() {
+    return schedule.skipped + droppedTicks;
+}
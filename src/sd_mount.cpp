@@ -0,0 +1,71 @@
+#include "sd_mount.h"
+
+SdMount sdMount;
+
+static bool deadlineReached(uint32_t nowMs, uint32_t deadlineMs) {
+    return (int32_t)(nowMs - deadlineMs) >= 0;
+}
+
+// Retry delays run 250 ms, 500 ms, 1 s ... capped at SD_REMOUNT_BACKOFF_MAX_MS.
+static void scheduleRetry(SdMount& m, uint32_t nowMs) {
+    m.nextActionMs = nowMs + m.backoffMs;
+    m.backoffMs = m.backoffMs * 2 > SD_REMOUNT_BACKOFF_MAX_MS ? SD_REMOUNT_BACKOFF_MAX_MS : m.backoffMs * 2;
+}
+
+static void tryMount(SdMount& m, uint32_t nowMs) {
+    if (m.device->mount()) {
+        m.state.store(SdState::Mounted);
+        m.failureReported.store(false);
+        m.mountCount++;
+        m.backoffMs    = SD_REMOUNT_BACKOFF_MIN_MS;
+        m.nextActionMs = nowMs + SD_PROBE_PERIOD_MS;
+        return;
+    }
+
+    scheduleRetry(m, nowMs);
+}
+
+// Callers leave state alone while mounting at boot; a failed first mount is
+// retried by the tick just like a lost card.
+bool sdMountBegin(SdMount& m, BlockDevice& device, uint32_t nowMs) {
+    m.device = &device;
+    tryMount(m, nowMs);
+    return m.state.load() == SdState::Mounted;
+}
+
+void sdMountTick(SdMount& m, uint32_t nowMs) {
+    if (m.device == nullptr) return;
+
+    if (m.state.load() != SdState::Mounted) {
+        if (deadlineReached(nowMs, m.nextActionMs)) tryMount(m, nowMs);
+        return;
+    }
+
+    bool reported = m.failureReported.exchange(false);
+    if (!reported && !deadlineReached(nowMs, m.nextActionMs)) return;
+
+    if (m.device->probe()) {
+        m.nextActionMs = nowMs + SD_PROBE_PERIOD_MS;
+        return;
+    }
+
+    m.state.store(SdState::Lost);
+    m.lostCount++;
+    m.device->unmount();
+    m.backoffMs = SD_REMOUNT_BACKOFF_MIN_MS;
+    scheduleRetry(m, nowMs);
+}
+
+// Hot paths report a failed open/write instead of remounting; the next tick
+// confirms with a probe.
+void sdReportFailure(SdMount& m) {
+    m.failureReported.store(true);
+}
+
+const char* sdStateName(SdState state) {
+    switch (state) {
+        case SdState::Mounted: return "mounted";
+        case SdState::Lost:    return "lost";
+        default:               return "unmounted";
+    }
+}
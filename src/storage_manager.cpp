@@ -1,12 +1,171 @@
 #include "storage_manager.h"
 #include "suspension_cal.h"
+#include "pretrigger_buffer.h"
+#include "summary_pyramid.h"
+#include "sd_mount.h"
+#include "deferred_log.h"
 #include "globals.h"
 #include <SD.h>
+#include <SPI.h>
+#include <atomic>
 
 std::vector<SensorLine> sensorBuffer;
 
+static SummaryPyramid runPyramid;
+static uint32_t runSamplesWritten = 0;
+static uint32_t runBytesWritten   = 0;  // CSV length so far; seek-index offsets come from here
+
+// Bias updates wait here until the next flush writes them to the run's .bias sidecar.
+static constexpr size_t BIAS_QUEUE_LEN = 16;
+static BiasUpdate biasQueue[BIAS_QUEUE_LEN];
+static size_t   biasQueueCount   = 0;
+static uint32_t biasQueueDropped = 0;
+
+// Gaps wait the same way for the run's .gaps sidecar.
+static constexpr size_t GAP_QUEUE_LEN = 8;
+static SampleGap gapQueue[GAP_QUEUE_LEN];
+static size_t   gapQueueCount   = 0;
+static uint32_t gapQueueDropped = 0;
+
+static const char* const SUMMARY_SUFFIX[PYRAMID_LEVELS] = { ".sum0", ".sum1", ".sum2" };
+static const char* const BIAS_SUFFIX = ".bias";
+static const char* const INDEX_SUFFIX = ".idx";
+static const char* const INFO_SUFFIX = ".info";
+static const char* const GAPS_SUFFIX = ".gaps";
+
+static uint32_t droppedWhileUnmounted = 0;
+
+// Held by every run-file write and by mount/unmount, so the mount manager on
+// core 1 can never pull the volume out from under a flush on core 0.
+static SemaphoreHandle_t sdIoLock = NULL;
+
+// Web downloads holding a file open. Longer than AsyncTCP's 5 s ack timeout, so
+// by the end of the wait even a stalled client's response has been freed.
+static std::atomic<int> openSdStreams{0};
+static constexpr uint32_t SD_STREAM_DRAIN_MS = 6000;
+
+// SD-over-SPI backing for the mount manager.
+struct SdCardDevice : BlockDevice {
+    bool mount() override {
+        xSemaphoreTake(sdIoLock, portMAX_DELAY);
+        bool ok = SD.begin(SD_CS_PIN, SPI, 4000000, "/sd", SD_MAX_OPEN_FILES);
+        if (ok && !SD.exists(RUN_META_DIR)) SD.mkdir(RUN_META_DIR);
+        xSemaphoreGive(sdIoLock);
+        return ok;
+    }
+
+    // sdMounted() is already false, so streams close their files on their next
+    // read; SD.end() waits for that rather than pulling the volume from under them.
+    void unmount() override {
+        uint32_t start = millis();
+        while (openSdStreams.load() > 0 && millis() - start < SD_STREAM_DRAIN_MS) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+        if (openSdStreams.load() > 0) {
+            LOG_WARN("[SD] unmounting with %d web downloads still open", openSdStreams.load());
+        }
+
+        xSemaphoreTake(sdIoLock, portMAX_DELAY);
+        SD.end();
+        xSemaphoreGive(sdIoLock);
+    }
+
+    // Reads sector 0 straight from the card; cached FAT metadata would hide a removal.
+    // A flush in progress holds the lock and is itself proof of a working card.
+    bool probe() override {
+        static uint8_t sector[512];
+        if (xSemaphoreTake(sdIoLock, 0) != pdTRUE) return true;
+        bool ok = SD.readRAW(sector, 0);
+        xSemaphoreGive(sdIoLock);
+        return ok;
+    }
+};
+
+static SdCardDevice sdCard;
+
 bool initStorage() {
-    return SD.begin(SD_CS_PIN);
+    sdIoLock = xSemaphoreCreateMutex();
+    return sdMountBegin(sdMount, sdCard, millis());
+}
+
+bool lockSdIo(TickType_t wait) {
+    if (!sdMounted() || xSemaphoreTake(sdIoLock, wait) != pdTRUE) return false;
+    if (sdMounted()) return true;
+    xSemaphoreGive(sdIoLock);
+    return false;
+}
+
+void unlockSdIo() {
+    xSemaphoreGive(sdIoLock);
+}
+
+std::shared_ptr<SdStream> openSdStream(const String& path) {
+    auto stream = std::make_shared<SdStream>();
+    stream->file = SD.open(path.c_str(), FILE_READ);
+    if (!stream->file) return nullptr;
+
+    stream->open = true;
+    openSdStreams++;
+    return stream;
+}
+
+void closeSdStream(SdStream& stream) {
+    if (!stream.open) return;
+
+    xSemaphoreTake(sdIoLock, portMAX_DELAY);
+    stream.file.close();
+    xSemaphoreGive(sdIoLock);
+    stream.open = false;
+    openSdStreams--;
+}
+
+SdStream::~SdStream() {
+    closeSdStream(*this);
+}
+
+void storageTick() {
+    SdState before = sdMount.state.load();
+    sdMountTick(sdMount, millis());
+    SdState after = sdMount.state.load();
+
+    if (before != after) {
+        LOG_INFO("[SD] card %s (mounts=%u losses=%u)", sdStateName(after),
+                 (unsigned)sdMount.mountCount, (unsigned)sdMount.lostCount);
+    }
+}
+
+// "/run_5.csv" + ".sum0" -> "/meta/run_5.sum0"
+String runSidecarPath(const String& runPath, const char* suffix) {
+    String name = runPath.startsWith("/") ? runPath.substring(1) : runPath;
+    int dot = name.lastIndexOf('.');
+    if (dot > 0) name = name.substring(0, dot);
+    return String(RUN_META_DIR) + "/" + name + suffix;
+}
+
+String summaryPath(const String& runPath, int level) {
+    return runSidecarPath(runPath, SUMMARY_SUFFIX[level]);
+}
+
+// Seek index: little-endian uint32 byte offsets into the run CSV, entry k pointing
+// at the start of sample k * SEEK_INDEX_INTERVAL. Entry 0 is therefore the length
+// of the header and calibration lines.
+String seekIndexPath(const String& runPath) {
+    return runSidecarPath(runPath, INDEX_SUFFIX);
+}
+
+void removeRunSidecars(const String& runPath) {
+    for (int l = 0; l < PYRAMID_LEVELS; l++) {
+        String path = summaryPath(runPath, l);
+        if (SD.exists(path)) SD.remove(path);
+    }
+    String biasPath = runSidecarPath(runPath, BIAS_SUFFIX);
+    if (SD.exists(biasPath)) SD.remove(biasPath);
+    String indexPath = seekIndexPath(runPath);
+    if (SD.exists(indexPath)) SD.remove(indexPath);
+    String infoPath = runSidecarPath(runPath, INFO_SUFFIX);
+    if (SD.exists(infoPath)) SD.remove(infoPath);
+    String gapsPath = runSidecarPath(runPath, GAPS_SUFFIX);
+    if (SD.exists(gapsPath)) SD.remove(gapsPath);
 }
 
 static int parseRunNumber(const String& fname) {
@@ -63,51 +222,360 @@ static void writeRunHeader(File& file, const int initialAcc[6]) {
     file.println(correctSuspension(rawFront, FRONT_SUS_CAL, FRONT_SUS_CAL_SIZE));
 }
 
-void startNewRun(const int initialAcc[6]) {
-    if (!SD.begin(SD_CS_PIN)) {
-        Serial.println("[ERROR] SD Card mount failed");
+// Run properties that don't belong in the CSV: "key=value" lines in /meta/run_N.info.
+static const char RATE_KEY[] = "sample_rate_hz=";
+
+static void writeRunInfo(const String& runPath, uint32_t rateHz) {
+    File file = SD.open(runSidecarPath(runPath, INFO_SUFFIX).c_str(), FILE_WRITE);
+    if (!file) return;
+    file.print(RATE_KEY);
+    file.println(rateHz);
+    file.close();
+}
+
+uint32_t readRunSampleRate(const String& runPath) {
+    File file = SD.open(runSidecarPath(runPath, INFO_SUFFIX).c_str(), FILE_READ);
+    if (!file) return DEFAULT_SAMPLE_RATE_HZ;
+
+    long rate = 0;
+    while (file.available() && rate <= 0) {
+        String line = file.readStringUntil('\n');
+        line.trim();
+        if (line.startsWith(RATE_KEY)) rate = line.substring(sizeof(RATE_KEY) - 1).toInt();
+    }
+    file.close();
+    return rate > 0 ? (uint32_t)rate : DEFAULT_SAMPLE_RATE_HZ;
+}
+
+bool startNewRun(const int initialAcc[6], uint32_t rateHz) {
+    currentRunFilePath = "";  // never let a new session append to the previous run
+    sensorBuffer.clear();
+
+    if (!sdMounted()) {
+        LOG_ERROR("[ERROR] SD Card not mounted");
         setLedColor(0, 0, 255);
-        return;
+        return false;
     }
 
+    xSemaphoreTake(sdIoLock, portMAX_DELAY);
     int nextRun = findNextRunNumber();
     currentRunFilePath = "/run_" + String(nextRun) + ".csv";
 
     File file = SD.open(currentRunFilePath.c_str(), FILE_WRITE);
     if (!file) {
-        Serial.println("[ERROR] Failed to create run file: " + currentRunFilePath);
+        xSemaphoreGive(sdIoLock);
+        sdReportFailure(sdMount);
+        LOG_ERROR("[ERROR] Failed to create run file: /run_%d.csv", nextRun);
+        currentRunFilePath = "";
         setLedColor(0, 0, 255);
-        return;
+        return false;
     }
 
     writeRunHeader(file, initialAcc);
+    runBytesWritten = file.position();
     file.close();
 
-    sensorBuffer.clear();
-    Serial.println("[INFO] New run started: " + currentRunFilePath);
+    removeRunSidecars(currentRunFilePath);  // stale sidecars left by a run deleted without them
+    writeRunInfo(currentRunFilePath, rateHz);
+    resetPyramid(runPyramid, rateHz);
+    runSamplesWritten = 0;
+    biasQueueCount    = 0;
+    biasQueueDropped  = 0;
+    gapQueueCount     = 0;
+    gapQueueDropped   = 0;
+
+    File biasFile = SD.open(runSidecarPath(currentRunFilePath, BIAS_SUFFIX).c_str(), FILE_WRITE);
+    if (biasFile) {
+        biasFile.println("sample,gyro_bias_x,gyro_bias_y,gyro_bias_z,accel_bias_x,accel_bias_y,accel_bias_z,grav_mag");
+        biasFile.close();
+    }
+    xSemaphoreGive(sdIoLock);
+    droppedWhileUnmounted = 0;
+
+    LOG_INFO("[INFO] New run started: /run_%d.csv", nextRun);
+    return true;
 }
 
-void flushSensorBuffer() {
-    if (sensorBuffer.empty() || currentRunFilePath == "") return;
-    
+// The run CSV plus its summary sidecars, open for the duration of one flush.
+struct RunFiles {
+    File csv;
+    File summary[PYRAMID_LEVELS];
+    File index;
+};
 
-    File file = SD.open(currentRunFilePath.c_str(), FILE_APPEND);
-    if (!file) {
-        Serial.println("[ERROR] Failed to open run file for writing");
+static void closeRunFiles(RunFiles& files) {
+    if (files.csv) files.csv.close();
+    for (int l = 0; l < PYRAMID_LEVELS; l++) {
+        if (files.summary[l]) files.summary[l].close();
+    }
+    if (files.index) files.index.close();
+}
+
+// All or nothing: summary record k must sit at k * sizeof(PyramidRecord) and seek
+// entry k must point at sample k * SEEK_INDEX_INTERVAL, so a flush that cannot
+// append to every sidecar must not append to any of them.
+static bool openRunFiles(RunFiles& files) {
+    files.csv = SD.open(currentRunFilePath.c_str(), FILE_APPEND);
+    bool ok = (bool)files.csv;
+
+    for (int l = 0; l < PYRAMID_LEVELS; l++) {
+        files.summary[l] = SD.open(summaryPath(currentRunFilePath, l).c_str(), FILE_APPEND);
+        ok = ok && files.summary[l];
+    }
+    files.index = SD.open(seekIndexPath(currentRunFilePath).c_str(), FILE_APPEND);
+    ok = ok && files.index;
+
+    if (!ok) closeRunFiles(files);
+    return ok;
+}
+
+static void writeSensorLine(RunFiles& files, const SensorLine& line) {
+    if (runSamplesWritten % SEEK_INDEX_INTERVAL == 0) {
+        files.index.write((const uint8_t*)&runBytesWritten, sizeof(runBytesWritten));
+    }
+
+    File& file = files.csv;
+    size_t n = 0;
+    for (int i = 0; i < 6; i++) {
+        n += file.print(line.acc[i]);
+        n += file.print(",");
+    }
+    n += file.print(line.rear_sus);
+    n += file.print(",");
+    n += file.println(line.front_sus);
+    runBytesWritten += n;
+
+    pyramidAddSample(runPyramid, line, files.summary);
+    runSamplesWritten++;
+}
+
+// Log-task sink. Never waits for the card: if a flush holds the lock the batch
+// goes to Serial only.
+void appendSystemLog(const char* data, size_t len) {
+    if (!sdMounted() || xSemaphoreTake(sdIoLock, 0) != pdTRUE) return;
+
+    File file = SD.open(SYSTEM_LOG_PATH, FILE_APPEND);
+    if (file) {
+        file.write((const uint8_t*)data, len);
+        file.close();
+    }
+    xSemaphoreGive(sdIoLock);
+}
+
+// Index of the next sample that will land in the run file.
+static uint32_t runSampleCursor() {
+    return runSamplesWritten + pretriggerPending() + sensorBuffer.size();
+}
+
+// Armed updates wait in the queue until the trigger. Of those stamped before the
+// oldest sample still in the ring only the latest matters (it is the bias in force
+// at that sample), so the rest are discarded and a long wait cannot fill the queue.
+static void pruneSupersededArmedUpdates() {
+    uint32_t oldest = pretriggerRing.pushed - pretriggerRing.count;
+    size_t superseded = 0;
+    while (superseded + 1 < biasQueueCount && biasQueue[superseded + 1].sample <= oldest) {
+        superseded++;
+    }
+    if (superseded == 0) return;
+
+    memmove(biasQueue, biasQueue + superseded, (biasQueueCount - superseded) * sizeof(BiasUpdate));
+    biasQueueCount -= superseded;
+}
+
+void logBiasUpdate(const float gyroBias[3], const float accelBias[3], float gravMag) {
+    bool armed = recording == 1 && !pretriggerRing.frozen;
+    if (armed) pruneSupersededArmedUpdates();
+
+    if (biasQueueCount >= BIAS_QUEUE_LEN) {
+        biasQueueDropped++;
         return;
     }
 
-    for (const auto& line : sensorBuffer) {
-        for (int i = 0; i < 6; i++) {
-            file.print(line.acc[i]);
-            file.print(",");
-        }
-        file.print(line.rear_sus);
-        file.print(",");
-        file.println(line.front_sus);
+    BiasUpdate& u = biasQueue[biasQueueCount++];
+    u.sample = armed ? pretriggerRing.pushed : runSampleCursor();
+    u.inRing = armed;
+    memcpy(u.gyroBias,  gyroBias,  sizeof(u.gyroBias));
+    memcpy(u.accelBias, accelBias, sizeof(u.accelBias));
+    u.gravMag = gravMag;
+}
+
+// The frozen ring is written first, so ring position p lands at run sample
+// runSamplesWritten + (p - oldest). Updates from before the oldest held sample
+// apply from the start of the ring.
+void anchorArmedBiasUpdates() {
+    uint32_t oldest = pretriggerRing.pushed - pretriggerRing.count;
+    for (size_t i = 0; i < biasQueueCount; i++) {
+        BiasUpdate& u = biasQueue[i];
+        if (!u.inRing) continue;
+        u.sample = runSamplesWritten + (u.sample > oldest ? u.sample - oldest : 0);
+        u.inRing = false;
     }
+}
+
+static void flushBiasUpdates() {
+    if (biasQueueCount == 0) return;
+
+    File file = SD.open(runSidecarPath(currentRunFilePath, BIAS_SUFFIX).c_str(), FILE_APPEND);
+    if (!file) return;
+
+    for (size_t i = 0; i < biasQueueCount; i++) {
+        const BiasUpdate& u = biasQueue[i];
+        file.printf("%u,%.5f,%.5f,%.5f,%.4f,%.4f,%.4f,%.4f\n", (unsigned)u.sample,
+                    u.gyroBias[0], u.gyroBias[1], u.gyroBias[2],
+                    u.accelBias[0], u.accelBias[1], u.accelBias[2], u.gravMag);
+    }
+    file.close();
+
+    if (biasQueueDropped > 0) {
+        LOG_WARN("[WARN] %u bias updates dropped (queue full)", (unsigned)biasQueueDropped);
+        biasQueueDropped = 0;
+    }
+    biasQueueCount = 0;
+}
+
+// Consecutive losses with no row written in between are one gap.
+static void queueSampleGap(uint32_t sample, uint32_t missing) {
+    if (gapQueueCount > 0 && gapQueue[gapQueueCount - 1].sample == sample) {
+        gapQueue[gapQueueCount - 1].missing += missing;
+        return;
+    }
+    if (gapQueueCount >= GAP_QUEUE_LEN) {
+        gapQueueDropped++;
+        return;
+    }
+    gapQueue[gapQueueCount++] = { sample, missing };
+}
+
+void logSampleGap(uint32_t missing) {
+    queueSampleGap(runSampleCursor(), missing);
+}
+
+// Kept queued if the sidecar cannot be opened; the next flush tries again.
+static void flushSampleGaps() {
+    if (gapQueueCount == 0) return;
+
+    File file = SD.open(runSidecarPath(currentRunFilePath, GAPS_SUFFIX).c_str(), FILE_APPEND);
+    if (!file) return;
 
+    if (file.size() == 0) file.println("sample,missing");
+    for (size_t i = 0; i < gapQueueCount; i++) {
+        file.printf("%u,%u\n", (unsigned)gapQueue[i].sample, (unsigned)gapQueue[i].missing);
+    }
     file.close();
-    Serial.printf("[INFO] Flushed %u lines to SD card\n", (unsigned)sensorBuffer.size());
+
+    if (gapQueueDropped > 0) {
+        LOG_WARN("[WARN] %u sample gaps not recorded (queue full)", (unsigned)gapQueueDropped);
+        gapQueueDropped = 0;
+    }
+    gapQueueCount = 0;
+}
+
+// Pre-trigger history precedes everything else captured since the trigger fired.
+// It goes out PRETRIGGER_FLUSH_CHUNK lines per flush so no flush is longer than a
+// normal one; live samples wait in sensorBuffer until it is drained.
+// Returns true once the ring is empty.
+static bool writePretriggerChunk(RunFiles& files) {
+    size_t pending = pretriggerPending();
+    if (pending == 0) return true;
+
+    size_t n = pending < PRETRIGGER_FLUSH_CHUNK ? pending : PRETRIGGER_FLUSH_CHUNK;
+    for (size_t i = 0; i < n; i++) {
+        writeSensorLine(files, pretriggerLineAt(pretriggerRing.drained + i));
+    }
+    pretriggerRing.drained += n;
+    if (pretriggerPending() > 0) return false;
+
+    LOG_INFO("[INFO] Flushed %u pre-trigger lines to SD card", (unsigned)pretriggerRing.count);
+    resetPretrigger();
+    return true;
+}
+
+// Dropping keeps sensorBuffer inside its reserved capacity. The lost lines
+// would have been the next rows, so the gap sits at runSamplesWritten, and bias
+// updates stamped inside it apply from the first row after it.
+static void dropUnwritableSamples() {
+    uint32_t count = sensorBuffer.size() + pretriggerPending();
+    droppedWhileUnmounted += count;
     sensorBuffer.clear();
-}
\ No newline at end of file
+    resetPretrigger();
+
+    if (currentRunFilePath != "") {
+        queueSampleGap(runSamplesWritten, count);
+        for (size_t i = 0; i < biasQueueCount; i++) {
+            if (!biasQueue[i].inRing && biasQueue[i].sample > runSamplesWritten) biasQueue[i].sample = runSamplesWritten;
+        }
+    }
+    LOG_ERROR("[ERROR] Run file unwritable (SD card %s) — dropped %u lines (%u this run)",
+              sdStateName(sdMount.state.load()), (unsigned)count, (unsigned)droppedWhileUnmounted);
+}
+
+// False if the run files could not be opened; everything stays buffered.
+static bool writeBufferedLines() {
+    if (currentRunFilePath == "" || !sdMounted()) return false;
+
+    xSemaphoreTake(sdIoLock, portMAX_DELAY);
+    RunFiles files;
+    if (!openRunFiles(files)) {
+        xSemaphoreGive(sdIoLock);
+        sdReportFailure(sdMount);
+        return false;
+    }
+
+    size_t written = 0;
+    if (writePretriggerChunk(files)) {
+        for (const auto& line : sensorBuffer) {
+            writeSensorLine(files, line);
+        }
+        written = sensorBuffer.size();
+    }
+
+    closeRunFiles(files);
+    flushBiasUpdates();
+    flushSampleGaps();
+    xSemaphoreGive(sdIoLock);
+
+    if (written > 0) {
+        LOG_INFO("[INFO] Flushed %u lines to SD card", (unsigned)written);
+        sensorBuffer.clear();
+    }
+    return true;
+}
+
+// A failed open is often transient (a remount in progress, web downloads holding
+// file handles), so the lines stay buffered and the caller retries every
+// FLUSH_RETRY_INTERVAL samples. They are dropped, and the gap recorded, only once
+// sensorBuffer reaches SENSOR_BUFFER_CAPACITY, there is no run, or the run is ending.
+static void flushRun(bool final) {
+    if (sensorBuffer.empty() && !hasPendingPretrigger()) return;
+    if (writeBufferedLines()) return;
+
+    if (!final && currentRunFilePath != "" && sensorBuffer.size() < SENSOR_BUFFER_CAPACITY) {
+        LOG_WARN("[WARN] Flush deferred (SD card %s) — holding %u lines",
+                 sdStateName(sdMount.state.load()), (unsigned)sensorBuffer.size());
+        return;
+    }
+    dropUnwritableSamples();
+}
+
+void flushSensorBuffer() {
+    flushRun(false);
+}
+
+void finishRun() {
+    // A run stopped right after its trigger may still hold undrained history.
+    do {
+        flushRun(true);
+    } while (pretriggerPending() > 0);
+    if (currentRunFilePath == "" || !sdMounted()) return;
+
+    xSemaphoreTake(sdIoLock, portMAX_DELAY);
+    flushBiasUpdates();  // updates that arrived after the last sample
+    flushSampleGaps();
+
+    RunFiles files;
+    if (openRunFiles(files)) {
+        pyramidFinish(runPyramid, files.summary);
+        closeRunFiles(files);
+    }
+    xSemaphoreGive(sdIoLock);
+}
@@ -0,0 +1,93 @@
+#include "summary_pyramid.h"
+#include <limits.h>
+
+// Children per bucket above level 0; level 0 closes on its time boundary instead.
+static constexpr uint32_t LEVEL_FANOUT[PYRAMID_LEVELS] = {
+    0,
+    PYRAMID_LEVEL_MS[1] / PYRAMID_LEVEL_MS[0],
+    PYRAMID_LEVEL_MS[2] / PYRAMID_LEVEL_MS[1],
+};
+
+static void resetBucket(PyramidBucket& b) {
+    for (int c = 0; c < PYRAMID_CHANNELS; c++) {
+        b.min[c] = INT32_MAX;
+        b.max[c] = INT32_MIN;
+        b.sum[c] = 0;
+    }
+    b.samples  = 0;
+    b.children = 0;
+}
+
+void resetPyramid(SummaryPyramid& pyr, uint32_t rateHz) {
+    for (int l = 0; l < PYRAMID_LEVELS; l++) resetBucket(pyr.levels[l]);
+    pyr.rateHz      = rateHz;
+    pyr.sampleIndex = 0;
+}
+
+// Index of the level-0 bucket that sample `i` falls in.
+static uint64_t level0Bucket(const SummaryPyramid& pyr, uint64_t i) {
+    return i * 1000 / ((uint64_t)pyr.rateHz * PYRAMID_LEVEL_MS[0]);
+}
+
+static void writeBucket(const PyramidBucket& b, File& out) {
+    PyramidRecord rec;
+    for (int c = 0; c < PYRAMID_CHANNELS; c++) {
+        rec.min[c]  = b.min[c];
+        rec.max[c]  = b.max[c];
+        rec.mean[c] = (int32_t)(b.sum[c] / (int64_t)b.samples);
+    }
+    out.write((const uint8_t*)&rec, sizeof(rec));
+}
+
+static void foldBucket(PyramidBucket& parent, const PyramidBucket& child) {
+    for (int c = 0; c < PYRAMID_CHANNELS; c++) {
+        if (child.min[c] < parent.min[c]) parent.min[c] = child.min[c];
+        if (child.max[c] > parent.max[c]) parent.max[c] = child.max[c];
+        parent.sum[c] += child.sum[c];
+    }
+    parent.samples += child.samples;
+    parent.children++;
+}
+
+// Writes the closed level-0 bucket and every parent it fills, cascading upwards.
+static void closeFullBuckets(SummaryPyramid& pyr, File out[PYRAMID_LEVELS]) {
+    for (int l = 0; l < PYRAMID_LEVELS; l++) {
+        PyramidBucket& b = pyr.levels[l];
+        if (l > 0 && b.children < LEVEL_FANOUT[l]) return;
+
+        writeBucket(b, out[l]);
+        if (l + 1 < PYRAMID_LEVELS) foldBucket(pyr.levels[l + 1], b);
+        resetBucket(b);
+    }
+}
+
+void pyramidAddSample(SummaryPyramid& pyr, const SensorLine& line, File out[PYRAMID_LEVELS]) {
+    const int32_t values[PYRAMID_CHANNELS] = {
+        line.acc[0], line.acc[1], line.acc[2], line.acc[3], line.acc[4], line.acc[5],
+        line.rear_sus, line.front_sus
+    };
+
+    PyramidBucket& b = pyr.levels[0];
+    for (int c = 0; c < PYRAMID_CHANNELS; c++) {
+        if (values[c] < b.min[c]) b.min[c] = values[c];
+        if (values[c] > b.max[c]) b.max[c] = values[c];
+        b.sum[c] += values[c];
+    }
+    b.samples++;
+    b.children++;
+
+    uint64_t i = pyr.sampleIndex++;
+    if (level0Bucket(pyr, i + 1) != level0Bucket(pyr, i)) closeFullBuckets(pyr, out);
+}
+
+// Emits the trailing partial bucket of every level at the end of a run.
+void pyramidFinish(SummaryPyramid& pyr, File out[PYRAMID_LEVELS]) {
+    for (int l = 0; l < PYRAMID_LEVELS; l++) {
+        PyramidBucket& b = pyr.levels[l];
+        if (b.samples == 0) continue;
+
+        writeBucket(b, out[l]);
+        if (l + 1 < PYRAMID_LEVELS) foldBucket(pyr.levels[l + 1], b);
+        resetBucket(b);
+    }
+}
@@ -4,67 +4,57 @@
 #include "storage_manager.h"
 #include "network_manager.h"
 #include "suspension_cal.h"
+#include "pretrigger_buffer.h"
+#include "deferred_log.h"
+#include "adc_filters.h"
+#include "sample_timer.h"
 
 // ─── Suspension ADC ───────────────────────────────────────────────────────────
 
-#define SUS_NUM_SAMPLES 20
-#define SUS_SIGMA_K     2.0f
-static_assert(SUS_NUM_SAMPLES >= 5, "SUS_NUM_SAMPLES must be >= 5 for a meaningful sigma estimate");
-
-// Takes SUS_NUM_SAMPLES rapid ADC reads, computes the burst mean and standard
-// deviation, then averages only the samples within SUS_SIGMA_K * sigma of the
-// mean. Outlier spikes separated from the cluster by >2σ are discarded.
-// At N=20, sigma is stable enough that a single spike cannot inflate it enough
-// to hide itself. Total time ~2 ms for both pins, well within the 10 ms window.
-static int stddevFilteredADC(uint8_t pin) {
-    int samples[SUS_NUM_SAMPLES];
-    for (int i = 0; i < SUS_NUM_SAMPLES; i++) {
+// Each channel picks its burst filter here (see adc_filters.h for the policies).
+// Sigma gating at 2σ over 20 reads discards isolated ADC spikes: at N=20 sigma is
+// stable enough that a single spike cannot inflate it enough to hide itself.
+// That costs ~2 ms for both pins, so with the IMU read a pass only fits in the
+// period up to SUS_LONG_BURST_MAX_HZ. Faster runs read 8 and drop the highest
+// and lowest (~0.8 ms), which still rejects one spike per burst.
+static constexpr int SUS_NUM_SAMPLES      = 20;
+static constexpr int SUS_FAST_NUM_SAMPLES = 8;
+static constexpr uint32_t SUS_LONG_BURST_MAX_HZ = 250;
+using RearSusFilter      = SigmaGatedMean<SUS_NUM_SAMPLES, 2>;
+using FrontSusFilter     = SigmaGatedMean<SUS_NUM_SAMPLES, 2>;
+using RearSusFastFilter  = TrimmedMean<SUS_FAST_NUM_SAMPLES, 1>;
+using FrontSusFastFilter = TrimmedMean<SUS_FAST_NUM_SAMPLES, 1>;
+
+static RearSusFilter      rearSusFilter;
+static FrontSusFilter     frontSusFilter;
+static RearSusFastFilter  rearSusFastFilter;
+static FrontSusFastFilter frontSusFastFilter;
+
+template <typename Filter>
+static int filteredADC(uint8_t pin, Filter& filter) {
+    int samples[Filter::SAMPLES];
+    for (int i = 0; i < Filter::SAMPLES; i++) {
         samples[i] = analogRead(pin);
     }
-
-    float sum = 0;
-    for (int i = 0; i < SUS_NUM_SAMPLES; i++) sum += samples[i];
-    float mean = sum / SUS_NUM_SAMPLES;
-
-    float variance = 0;
-    for (int i = 0; i < SUS_NUM_SAMPLES; i++) {
-        float diff = samples[i] - mean;
-        variance += diff * diff;
-    }
-    float sigma = sqrtf(variance / SUS_NUM_SAMPLES);
-
-    float lo = mean - SUS_SIGMA_K * sigma;
-    float hi = mean + SUS_SIGMA_K * sigma;
-    float filteredSum = 0;
-    int count = 0;
-    for (int i = 0; i < SUS_NUM_SAMPLES; i++) {
-        if (samples[i] >= lo && samples[i] <= hi) {
-            filteredSum += samples[i];
-            count++;
-        }
-    }
-
-    // Fallback: if every sample was rejected (degenerate — shouldn't happen),
-    // return the unfiltered mean rather than divide-by-zero.
-    if (count == 0) return (int)mean;
-    return (int)(filteredSum / count);
+    return filter.apply(samples);
 }
 
 // ─── Diagnostics ─────────────────────────────────────────────────────────────
 
-static constexpr int REPORT_PERIOD = 100;
-
+// One report per second of samples at the active rate.
 struct DiagState {
     uint32_t sampleCount  = 0;
     uint64_t accumLoopUs  = 0;
     uint64_t accumImuUs   = 0;
+    uint32_t lateTicks    = 0;  // ticks that were already pending when the loop came round
 };
 
 static void logDiagnostics(DiagState& diag) {
-    float avgLoopMs = (diag.accumLoopUs / (float)REPORT_PERIOD) / 1000.0f;
-    float avgImuMs  = (diag.accumImuUs  / (float)REPORT_PERIOD) / 1000.0f;
-    Serial.printf("[DIAG] samples=%u avg_loop=%.3f ms avg_imu=%.3f ms buffer=%u\n",
-                  diag.sampleCount, avgLoopMs, avgImuMs, (unsigned)sensorBuffer.size());
+    float avgLoopMs = (diag.accumLoopUs / (float)activeSampleRateHz) / 1000.0f;
+    float avgImuMs  = (diag.accumImuUs  / (float)activeSampleRateHz) / 1000.0f;
+    LOG_INFO("[DIAG] samples=%u rate=%u Hz avg_loop=%.3f ms avg_imu=%.3f ms buffer=%u late=%u skipped=%u",
+             diag.sampleCount, activeSampleRateHz, avgLoopMs, avgImuMs, (unsigned)sensorBuffer.size(),
+             diag.lateTicks, sampleTimerSkipped());
     diag.accumLoopUs = 0;
     diag.accumImuUs  = 0;
 }
@@ -96,31 +86,114 @@ static bool checkForButtonPress(ButtonState& btn) {
     return (reading == LOW);
 }
 
+// ─── Auto trigger ─────────────────────────────────────────────────────────────
+
+struct TriggerState {
+    int  lastRear       = 0;
+    int  lastFront      = 0;
+    bool primed         = false;  // lastRear/lastFront hold a real sample
+    bool autoTriggered  = false;  // current run was started by motion, not the button
+    uint32_t quietSamples = 0;
+};
+
+// True when any world-frame accel axis or either suspension velocity crosses its
+// threshold. Velocity is the per-sample travel delta scaled to counts per second.
+static bool detectMotion(TriggerState& trig, const SensorLine& line) {
+    bool motion = false;
+    for (int i = 3; i < 6; i++) {
+        if (abs(line.acc[i]) >= AUTO_TRIGGER_ACCEL_MG) motion = true;
+    }
+
+    if (trig.primed) {
+        long rearVel  = (long)(line.rear_sus  - trig.lastRear)  * (long)activeSampleRateHz;
+        long frontVel = (long)(line.front_sus - trig.lastFront) * (long)activeSampleRateHz;
+        if (labs(rearVel) >= AUTO_TRIGGER_SUS_VELOCITY || labs(frontVel) >= AUTO_TRIGGER_SUS_VELOCITY) {
+            motion = true;
+        }
+    }
+
+    trig.lastRear  = line.rear_sus;
+    trig.lastFront = line.front_sus;
+    trig.primed    = true;
+    return motion;
+}
+
+// Returns true once an auto-triggered run has seen AUTO_STOP_QUIET_MS without motion.
+static bool quietPeriodElapsed(TriggerState& trig, const SensorLine& line) {
+    if (detectMotion(trig, line)) trig.quietSamples = 0;
+    else trig.quietSamples++;
+
+    return trig.quietSamples >= AUTO_STOP_QUIET_MS * activeSampleRateHz / 1000;
+}
+
 // ─── Recording state machine ──────────────────────────────────────────────────
 
-static void startRecordingSetup(ImuState& imu, TickType_t& xLastWakeTime) {
-    setLedColor(0, 0, 0);  // off — collecting calibration data
+// Arming is instant once background tracking has seen a still window; only a
+// logger armed before the bike has ever been still falls back to blocking calibration.
+// The requested sample rate takes effect here, so a run never changes rate midway.
+// If no run file can be created the logger goes back to idle with the LED blue.
+static void startRecordingSetup(ImuState& imu, TriggerState& trig) {
+    if (requestedSampleRateHz != activeSampleRateHz) {
+        activeSampleRateHz = requestedSampleRateHz;
+        setImuSampleRate(imu, activeSampleRateHz);
+    }
 
-    calibrateImu(imu);
+    if (!imu.biasValid) {
+        setLedColor(0, 0, 0);  // off — collecting calibration data
+        calibrateImu(imu);
+    }
 
     SensorLine initialLine = {};
     populateImuReadingIntoLine(imu, initialLine);
-    startNewRun(initialLine.acc);
+    bool started = startNewRun(initialLine.acc, activeSampleRateHz);
+    sampleTimerSetRate(activeSampleRateHz);  // re-anchor after calibration delay
+    if (!started) {
+        recording = 0;
+        return;
+    }
+
+    resetPretrigger();
+    logBiasUpdate(imu.gyroBias, imu.accelBias, imu.gravMag);
+    imu.biasUpdated = false;
 
-    setLedColor(255, 155, 0);  // yellow — calibration done, ready to record
-    xLastWakeTime = xTaskGetTickCount();  // re-anchor after calibration delay
+    trig = TriggerState{};
+
+    setLedColor(255, 155, 0);  // yellow — calibration done, armed / ready to record
 }
 
-static void stopRecording() {
-    setLedColor(0, 255, 0); // green — stopped, idle
-    if (!sensorBuffer.empty()) flushSensorBuffer();
+// Online bias updates go into the active run's log; between runs they only
+// refresh ImuState for the next arm.
+static void handleBiasUpdate(ImuState& imu) {
+    if (!imu.biasUpdated) return;
+    imu.biasUpdated = false;
+
+    if (recording != 0) logBiasUpdate(imu.gyroBias, imu.accelBias, imu.gravMag);
+}
+
+static void startRecording(TriggerState& trig, bool autoTriggered) {
+    freezePretrigger();
+    anchorArmedBiasUpdates();
+    trig.autoTriggered = autoTriggered;
+    trig.quietSamples  = 0;
+    recording = 2;
 }
 
-static void handleButtonPress(ImuState& imu, TickType_t& xLastWakeTime) {
-    recording = (recording + 1) % 3;
+static void stopRecording(TriggerState& trig) {
+    recording = 0;
+    trig.autoTriggered = false;
+    setLedColor(0, 255, 0); // green — stopped, idle
+    finishRun();
+}
 
-    if (recording == 1) startRecordingSetup(imu, xLastWakeTime);
-    else if (recording == 0) stopRecording();
+static void handleButtonPress(ImuState& imu, TriggerState& trig) {
+    if (recording == 0) {
+        recording = 1;
+        startRecordingSetup(imu, trig);
+    } else if (recording == 1) {
+        startRecording(trig, false);
+    } else {
+        stopRecording(trig);
+    }
 }
 
 // ─── Sample capture ───────────────────────────────────────────────────────────
@@ -132,8 +205,11 @@ static SensorLine captureSensorLine(ImuState& imu, uint64_t& accumImuUs) {
     populateImuReadingIntoLine(imu, line);
     accumImuUs += micros() - tImuStart;
 
-    int rawRear  = 4095 - stddevFilteredADC(REAR_SUS_PIN);
-    int rawFront = stddevFilteredADC(FRONT_SUS_PIN);
+    bool fast    = activeSampleRateHz > SUS_LONG_BURST_MAX_HZ;
+    int rawRear  = 4095 - (fast ? filteredADC(REAR_SUS_PIN, rearSusFastFilter)
+                                : filteredADC(REAR_SUS_PIN, rearSusFilter));
+    int rawFront = fast ? filteredADC(FRONT_SUS_PIN, frontSusFastFilter)
+                        : filteredADC(FRONT_SUS_PIN, frontSusFilter);
 
     line.rear_sus  = correctSuspension(rawRear,  REAR_SUS_CAL,  REAR_SUS_CAL_SIZE);
     line.front_sus = correctSuspension(rawFront, FRONT_SUS_CAL, FRONT_SUS_CAL_SIZE);
@@ -141,15 +217,26 @@ static SensorLine captureSensorLine(ImuState& imu, uint64_t& accumImuUs) {
     return line;
 }
 
+// A full buffer always gets a flush at SENSOR_BUFFER_CAPACITY, which drops
+// rather than let push_back reallocate.
+static_assert((SENSOR_BUFFER_CAPACITY - MAX_BUFFER_SIZE) % FLUSH_RETRY_INTERVAL == 0,
+              "Flush retries must land on SENSOR_BUFFER_CAPACITY");
+
+// Right after a trigger the frozen ring is drained one chunk every
+// PRETRIGGER_DRAIN_INTERVAL samples, with live samples queued behind it. A full
+// buffer whose flush failed is retried every FLUSH_RETRY_INTERVAL samples.
 static void bufferSample(const SensorLine& line) {
     sensorBuffer.push_back(line);
 
-    if (sensorBuffer.size() >= MAX_BUFFER_SIZE) {
+    size_t size = sensorBuffer.size();
+    bool drainDue = pretriggerPending() > 0 && size % PRETRIGGER_DRAIN_INTERVAL == 0;
+    bool flushDue = size >= MAX_BUFFER_SIZE && (size - MAX_BUFFER_SIZE) % FLUSH_RETRY_INTERVAL == 0;
+    if (drainDue || flushDue) {
         flushSensorBuffer();
     }
 }
 
-static void recordSample(ImuState& imu, DiagState& diag) {
+static SensorLine recordSample(ImuState& imu, DiagState& diag) {
     setLedColor(255, 0, 0); // red — recording
 
     uint32_t t0 = micros();
@@ -160,40 +247,77 @@ static void recordSample(ImuState& imu, DiagState& diag) {
     diag.sampleCount++;
     diag.accumLoopUs += micros() - t0;
 
-    if ((diag.sampleCount % REPORT_PERIOD) == 0) {
+    if ((diag.sampleCount % activeSampleRateHz) == 0) {
         logDiagnostics(diag);
     }
+    return line;
+}
+
+// Armed: keep the pre-trigger ring topped up and start recording on motion.
+static void armedSample(ImuState& imu, TriggerState& trig) {
+    uint64_t imuUs = 0;  // armed samples are not part of the recording diagnostics
+    SensorLine line = captureSensorLine(imu, imuUs);
+    pushPretriggerSample(line);
+
+    if (detectMotion(trig, line)) {
+        startRecording(trig, true);
+        LOG_INFO("[INFO] Auto trigger — %u pre-trigger samples held", (unsigned)pretriggerRing.count);
+    }
 }
 
 // ─── Task entry points ────────────────────────────────────────────────────────
 
 void DataTaskcode(void* pvParameter) {
-    sensorBuffer.reserve(MAX_BUFFER_SIZE);
+    sensorBuffer.reserve(SENSOR_BUFFER_CAPACITY);
 
     static ImuState imu;
     initImu(imu);
 
-    ButtonState button;
-    DiagState   diag;
+    ButtonState  button;
+    DiagState    diag;
+    TriggerState trig;
+    uint32_t     skippedSeen = 0;
 
-    TickType_t xLastWakeTime = xTaskGetTickCount();
+    if (!sampleTimerStart(xTaskGetCurrentTaskHandle(), activeSampleRateHz)) {
+        LOG_ERROR("[ERROR] Sample timer failed to start");
+        setLedColor(0, 0, 255);
+        vTaskDelete(NULL);
+    }
 
     while (true) {
+        // A backlog of pending ticks means the previous pass overran its period;
+        // they are worked off one per pass so no sample slot is lost.
+        if (sampleTimerWait() > 1 && recording == 2) diag.lateTicks++;
+
+        // Deadlines the clock skipped or dropped have no row; mark them in the run
+        // so the rows after them keep their time. The count restarts with each run.
+        uint32_t skipped = sampleTimerSkipped();
+        if (recording == 2 && skipped > skippedSeen) logSampleGap(skipped - skippedSeen);
+        skippedSeen = skipped;
+
         if (checkForButtonPress(button)) {
-            handleButtonPress(imu, xLastWakeTime);
+            handleButtonPress(imu, trig);
         }
 
-        if (recording == 2) {
-            recordSample(imu, diag);
+        if (recording == 0 || (recording == 1 && !AUTO_TRIGGER_ENABLED)) {
+            trackImuBias(imu);
+        } else if (recording == 1) {
+            armedSample(imu, trig);
+        } else if (recording == 2) {
+            SensorLine line = recordSample(imu, diag);
+            if (trig.autoTriggered && quietPeriodElapsed(trig, line)) {
+                LOG_INFO("[INFO] Auto stop — quiet period elapsed");
+                stopRecording(trig);
+            }
         }
 
-        vTaskDelayUntil(&xLastWakeTime, pdMS_TO_TICKS(SAMPLE_PERIOD_MS));
+        handleBiasUpdate(imu);
     }
 }
 
 void WiFiTaskcode(void* pvParameter) {
     WiFi.softAP("SDSD", "SDSD1234");
-    Serial.println("[WIFI] AP started — SSID: SDSD, IP: 192.168.4.1");
+    LOG_INFO("[WIFI] AP started — SSID: SDSD, IP: 192.168.4.1");
     setupWebRoutes();
     server.begin();
 
@@ -201,6 +325,7 @@ void WiFiTaskcode(void* pvParameter) {
 
     while (true) {
         updateOnBoardLed();
+        storageTick();
 
         unsigned long now = millis();
         if (now - lastBatteryReadMs >= BATTERY_READ_INTERVAL_MS) {
@@ -213,7 +338,7 @@ void WiFiTaskcode(void* pvParameter) {
             batteryPercent = (int)pct;
 
             updateBatteryNeopixel();
-            Serial.printf("[BATT] voltage=%.3fV percent=%d%%\n", voltage, batteryPercent);
+            LOG_INFO("[BATT] voltage=%.3fV percent=%d%%", voltage, (int)batteryPercent);
         }
 
         vTaskDelay(50 / portTICK_PERIOD_MS);
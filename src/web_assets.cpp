@@ -0,0 +1,105 @@
+#include "web_assets.h"
+#include "globals.h"
+#include "deferred_log.h"
+#include <LittleFS.h>
+
+static constexpr size_t MAX_WEB_ASSETS   = 16;
+static constexpr size_t ASSET_PATH_MAX   = 40;
+static constexpr size_t ASSET_ETAG_MAX   = 20;  // quoted 12-char hash
+static const char* const ASSET_MANIFEST  = "/assets.txt";
+
+// HTML is revalidated on every load (cheap 304); everything else is referenced
+// from HTML with ?v=<hash>, so a changed file always has a new URL.
+static const char* const CACHE_REVALIDATE = "no-cache";
+static const char* const CACHE_IMMUTABLE  = "public, max-age=31536000, immutable";
+
+struct WebAsset {
+    char path[ASSET_PATH_MAX];
+    char etag[ASSET_ETAG_MAX];
+};
+
+static WebAsset webAssets[MAX_WEB_ASSETS];
+static size_t   webAssetCount = 0;
+
+static bool endsWith(const char* s, const char* suffix) {
+    size_t n = strlen(s), m = strlen(suffix);
+    return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+static const char* mimeTypeFor(const char* path) {
+    if (endsWith(path, ".html") || endsWith(path, ".htm")) return "text/html";
+    if (endsWith(path, ".css"))  return "text/css";
+    if (endsWith(path, ".js"))   return "application/javascript";
+    if (endsWith(path, ".json")) return "application/json";
+    if (endsWith(path, ".svg"))  return "image/svg+xml";
+    if (endsWith(path, ".png"))  return "image/png";
+    if (endsWith(path, ".ico"))  return "image/x-icon";
+    return "application/octet-stream";
+}
+
+static bool isHtml(const char* path) {
+    return endsWith(path, ".html") || endsWith(path, ".htm");
+}
+
+bool initWebAssets() {
+    if (!LittleFS.begin()) {
+        LOG_WARN("[WEB] LittleFS mount failed — dashboard unavailable");
+        return false;
+    }
+
+    File manifest = LittleFS.open(ASSET_MANIFEST, FILE_READ);
+    if (!manifest) {
+        LOG_WARN("[WEB] %s missing — upload the filesystem image", ASSET_MANIFEST);
+        return false;
+    }
+
+    webAssetCount = 0;
+    while (manifest.available() && webAssetCount < MAX_WEB_ASSETS) {
+        String line = manifest.readStringUntil('\n');
+        line.trim();  // tolerate a manifest written with CRLF line endings
+        int space = line.indexOf(' ');
+        if (space <= 0) continue;
+
+        WebAsset& asset = webAssets[webAssetCount++];
+        snprintf(asset.path, sizeof(asset.path), "%s", line.substring(0, space).c_str());
+        snprintf(asset.etag, sizeof(asset.etag), "\"%s\"", line.substring(space + 1).c_str());
+    }
+    manifest.close();
+
+    LOG_INFO("[WEB] %u dashboard assets loaded", (unsigned)webAssetCount);
+    return true;
+}
+
+static void sendAsset(AsyncWebServerRequest* request, const WebAsset& asset) {
+    const char* cacheControl = isHtml(asset.path) ? CACHE_REVALIDATE : CACHE_IMMUTABLE;
+
+    if (request->hasHeader("If-None-Match") && request->getHeader("If-None-Match")->value() == asset.etag) {
+        AsyncWebServerResponse* response = request->beginResponse(304);
+        response->addHeader("ETag", asset.etag);
+        response->addHeader("Cache-Control", cacheControl);
+        request->send(response);
+        return;
+    }
+
+    // Only <path>.gz exists in LittleFS; AsyncFileResponse picks it up and sets
+    // Content-Encoding: gzip itself.
+    AsyncWebServerResponse* response = request->beginResponse(LittleFS, asset.path, mimeTypeFor(asset.path));
+    response->addHeader("ETag", asset.etag);
+    response->addHeader("Cache-Control", cacheControl);
+    request->send(response);
+}
+
+void setupAssetRoutes() {
+    for (size_t i = 0; i < webAssetCount; i++) {
+        const WebAsset& asset = webAssets[i];
+        server.on(asset.path, HTTP_GET, [&asset](AsyncWebServerRequest *request) {
+            sendAsset(request, asset);
+        });
+
+        if (strcmp(asset.path, "/index.html") == 0) {
+            server.on("/", HTTP_GET, [&asset](AsyncWebServerRequest *request) {
+                sendAsset(request, asset);
+            });
+        }
+    }
+}
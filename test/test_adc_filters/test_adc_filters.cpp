@@ -0,0 +1,253 @@
+#include <unity.h>
+#include <math.h>
+#include <stdlib.h>
+#include <algorithm>
+#include "adc_filters.h"
+
+static constexpr int BURST      = 20;  // SUS_NUM_SAMPLES in telemetry_tasks.cpp
+static constexpr int FAST_BURST = 8;   // SUS_FAST_NUM_SAMPLES, used above 250 Hz
+
+// Same noise model as the on-target benchmark (adc_filter_bench.cpp): ~6-count
+// noise as a sum of four uniforms, clamped to the 12-bit ADC range, optionally
+// with one full-scale spike.
+static uint32_t lcgState;
+static int lcgNext(int range) {
+    lcgState = lcgState * 1664525u + 1013904223u;
+    return (int)((lcgState >> 8) % (uint32_t)range);
+}
+
+static void noisyBurst(int* out, int truth, bool spike, int n = BURST) {
+    for (int i = 0; i < n; i++) {
+        int v = truth + lcgNext(11) + lcgNext(11) + lcgNext(11) + lcgNext(11) - 20;
+        out[i] = v < 0 ? 0 : (v > 4095 ? 4095 : v);
+    }
+    if (spike) out[lcgNext(n)] = lcgNext(2) ? 4095 : 0;
+}
+
+// The float filter the integer SigmaGatedMean replaced (stddevFilteredADC).
+static int floatSigmaFilter(const int* samples, float k) {
+    float sum = 0;
+    for (int i = 0; i < BURST; i++) sum += samples[i];
+    float mean = sum / BURST;
+
+    float variance = 0;
+    for (int i = 0; i < BURST; i++) {
+        float diff = samples[i] - mean;
+        variance += diff * diff;
+    }
+    float sigma = sqrtf(variance / BURST);
+
+    float lo = mean - k * sigma;
+    float hi = mean + k * sigma;
+    float filteredSum = 0;
+    int count = 0;
+    for (int i = 0; i < BURST; i++) {
+        if (samples[i] >= lo && samples[i] <= hi) {
+            filteredSum += samples[i];
+            count++;
+        }
+    }
+    if (count == 0) return (int)mean;
+    return (int)(filteredSum / count);
+}
+
+void setUp() { lcgState = 12345; }
+void tearDown() {}
+
+// ─── Kernels ──────────────────────────────────────────────────────────────────
+
+// 0-1 principle: a comparator network sorts every input iff it sorts every 0/1 input.
+template <int N>
+static void checkSortingNetworkZeroOne() {
+    for (uint32_t bits = 0; bits < (1u << N); bits++) {
+        int v[N];
+        for (int i = 0; i < N; i++) v[i] = (bits >> i) & 1;
+        adc_filter_detail::sortingNetwork<N>(v);
+        for (int i = 1; i < N; i++) {
+            if (v[i - 1] > v[i]) TEST_FAIL_MESSAGE("sorting network left a 0/1 input unsorted");
+        }
+    }
+}
+
+static void test_sorting_network_sorts_all_zero_one_inputs() {
+    checkSortingNetworkZeroOne<5>();
+    checkSortingNetworkZeroOne<8>();
+    checkSortingNetworkZeroOne<13>();
+    checkSortingNetworkZeroOne<16>();
+    checkSortingNetworkZeroOne<BURST - 1>();
+    checkSortingNetworkZeroOne<BURST>();
+}
+
+static void test_isqrt64_is_floor_sqrt() {
+    const uint64_t edges[] = { 0, 1, 2, 3, 4, 15, 16, 17, 1ULL << 32, (1ULL << 32) - 1,
+                               4095ULL * 4095 * 128 * 128, UINT64_MAX >> 2 };
+    for (uint64_t x : edges) {
+        uint64_t r = adc_filter_detail::isqrt64(x);
+        TEST_ASSERT_TRUE(r * r <= x);
+        TEST_ASSERT_TRUE((r + 1) * (r + 1) > x);
+    }
+    for (int i = 0; i < 100000; i++) {
+        uint64_t x = ((uint64_t)lcgNext(1 << 24) << 24) | (uint64_t)lcgNext(1 << 24);
+        uint64_t r = adc_filter_detail::isqrt64(x);
+        TEST_ASSERT_TRUE(r * r <= x && (r + 1) * (r + 1) > x);
+    }
+}
+
+// ─── Policies against references ──────────────────────────────────────────────
+
+static void test_sigma_gated_mean_matches_float_filter() {
+    SigmaGatedMean<BURST, 2> filter;
+    int samples[BURST];
+    for (int b = 0; b < 200000; b++) {
+        noisyBurst(samples, 100 + (b % 3900), b % 8 == 0);
+        TEST_ASSERT_EQUAL_INT(floatSigmaFilter(samples, 2.0f), filter.apply(samples));
+    }
+}
+
+static void test_sigma_gated_mean_constant_burst() {
+    SigmaGatedMean<BURST, 2> filter;
+    int samples[BURST];
+    for (int i = 0; i < BURST; i++) samples[i] = 1234;
+    TEST_ASSERT_EQUAL_INT(1234, filter.apply(samples));  // zero sigma keeps every sample
+}
+
+static void test_median_and_trimmed_mean_match_sorted_reference() {
+    MedianOfN<BURST>      median;
+    MedianOfN<BURST - 1>  oddMedian;
+    TrimmedMean<BURST, 4> trimmed;
+    int samples[BURST], sorted[BURST];
+
+    for (int b = 0; b < 20000; b++) {
+        noisyBurst(samples, 2048, b % 4 == 0);
+        std::copy(samples, samples + BURST, sorted);
+        std::sort(sorted, sorted + BURST);
+
+        TEST_ASSERT_EQUAL_INT((sorted[BURST / 2 - 1] + sorted[BURST / 2]) / 2, median.apply(samples));
+
+        int oddSorted[BURST - 1];
+        std::copy(samples, samples + BURST - 1, oddSorted);
+        std::sort(oddSorted, oddSorted + BURST - 1);
+        TEST_ASSERT_EQUAL_INT(oddSorted[(BURST - 1) / 2], oddMedian.apply(samples));
+
+        int32_t sum = 0;
+        for (int i = 4; i < BURST - 4; i++) sum += sorted[i];
+        TEST_ASSERT_EQUAL_INT(sum / (BURST - 8), trimmed.apply(samples));
+    }
+}
+
+// ─── Accuracy on the noise model ─────────────────────────────────────────────
+
+struct ErrorStats {
+    double mean;
+    int    max;
+};
+
+template <typename Filter>
+static ErrorStats measureError(bool spikes) {
+    lcgState = 12345;
+    Filter filter;
+    int samples[BURST];
+    double errSum = 0;
+    int errMax = 0;
+    const int bursts = 20000;
+
+    for (int b = 0; b < bursts; b++) {
+        int truth = 200 + (b % 3600);
+        noisyBurst(samples, truth, spikes && b % 8 == 0, Filter::SAMPLES);
+        int err = abs(filter.apply(samples) - truth);
+        errSum += err;
+        if (err > errMax) errMax = err;
+    }
+    return { errSum / bursts, errMax };
+}
+
+// Bounds are a little above what each policy achieves, so a regression in any
+// kernel shows up here rather than as noisier travel traces.
+static void test_error_bounds_without_spikes() {
+    ErrorStats mean   = measureError<BurstMean<BURST>>(false);
+    ErrorStats sigma  = measureError<SigmaGatedMean<BURST, 2>>(false);
+    ErrorStats median = measureError<MedianOfN<BURST>>(false);
+    ErrorStats trim   = measureError<TrimmedMean<BURST, 4>>(false);
+
+    TEST_ASSERT_TRUE(mean.mean   <= 1.3);  TEST_ASSERT_LESS_OR_EQUAL(7, mean.max);
+    TEST_ASSERT_TRUE(sigma.mean  <= 1.4);  TEST_ASSERT_LESS_OR_EQUAL(8, sigma.max);
+    TEST_ASSERT_TRUE(median.mean <= 1.5);  TEST_ASSERT_LESS_OR_EQUAL(9, median.max);
+    TEST_ASSERT_TRUE(trim.mean   <= 1.4);  TEST_ASSERT_LESS_OR_EQUAL(8, trim.max);
+}
+
+// One full-scale spike in 20 reads drags a plain mean by up to ~200 counts;
+// every rejecting policy must stay within its no-spike bounds.
+static void test_spikes_are_rejected() {
+    ErrorStats mean   = measureError<BurstMean<BURST>>(true);
+    ErrorStats sigma  = measureError<SigmaGatedMean<BURST, 2>>(true);
+    ErrorStats median = measureError<MedianOfN<BURST>>(true);
+    ErrorStats trim   = measureError<TrimmedMean<BURST, 4>>(true);
+
+    TEST_ASSERT_TRUE(mean.max > 100);
+    TEST_ASSERT_TRUE(sigma.mean  <= 1.4);  TEST_ASSERT_LESS_OR_EQUAL(8, sigma.max);
+    TEST_ASSERT_TRUE(median.mean <= 1.5);  TEST_ASSERT_LESS_OR_EQUAL(9, median.max);
+    TEST_ASSERT_TRUE(trim.mean   <= 1.4);  TEST_ASSERT_LESS_OR_EQUAL(8, trim.max);
+}
+
+// The short burst trades some noise for time; dropping one read at each end
+// must still reject a spike.
+static void test_fast_burst_rejects_spikes() {
+    ErrorStats mean   = measureError<BurstMean<FAST_BURST>>(true);
+    ErrorStats clean  = measureError<TrimmedMean<FAST_BURST, 1>>(false);
+    ErrorStats spiked = measureError<TrimmedMean<FAST_BURST, 1>>(true);
+
+    TEST_ASSERT_TRUE(mean.max > 100);
+    TEST_ASSERT_TRUE(clean.mean  <= 2.1);  TEST_ASSERT_LESS_OR_EQUAL(10, clean.max);
+    TEST_ASSERT_TRUE(spiked.mean <= 2.1);  TEST_ASSERT_LESS_OR_EQUAL(11, spiked.max);
+}
+
+static void test_smoothed_seeds_then_converges() {
+    Smoothed<BurstMean<BURST>, 2> filter;
+    int samples[BURST];
+
+    for (int i = 0; i < BURST; i++) samples[i] = 1000;
+    TEST_ASSERT_EQUAL_INT(1000, filter.apply(samples));  // first burst seeds, no ramp from 0
+
+    for (int i = 0; i < BURST; i++) samples[i] = 2000;
+    TEST_ASSERT_EQUAL_INT(1250, filter.apply(samples));  // alpha = 1/4
+
+    int out = 0;
+    for (int b = 0; b < 60; b++) out = filter.apply(samples);
+    TEST_ASSERT_INT_WITHIN(1, 2000, out);  // 24.8 state does not stall short of the step
+}
+
+// Held travel: smoothing trades lag (not measured here) for less burst-to-burst jitter.
+template <typename Filter>
+static int maxErrorAtRest() {
+    lcgState = 12345;
+    Filter filter;
+    int samples[BURST];
+    int errMax = 0;
+    for (int b = 0; b < 20000; b++) {
+        noisyBurst(samples, 2048, false);
+        int err = abs(filter.apply(samples) - 2048);
+        if (b > 10 && err > errMax) errMax = err;  // skip the settling bursts
+    }
+    return errMax;
+}
+
+static void test_smoothed_reduces_noise() {
+    int raw      = maxErrorAtRest<SigmaGatedMean<BURST, 2>>();
+    int smoothed = maxErrorAtRest<Smoothed<SigmaGatedMean<BURST, 2>, 2>>();
+    TEST_ASSERT_LESS_OR_EQUAL(raw, smoothed);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_sorting_network_sorts_all_zero_one_inputs);
+    RUN_TEST(test_isqrt64_is_floor_sqrt);
+    RUN_TEST(test_sigma_gated_mean_matches_float_filter);
+    RUN_TEST(test_sigma_gated_mean_constant_burst);
+    RUN_TEST(test_median_and_trimmed_mean_match_sorted_reference);
+    RUN_TEST(test_error_bounds_without_spikes);
+    RUN_TEST(test_spikes_are_rejected);
+    RUN_TEST(test_fast_burst_rejects_spikes);
+    RUN_TEST(test_smoothed_seeds_then_converges);
+    RUN_TEST(test_smoothed_reduces_noise);
+    return UNITY_END();
+}
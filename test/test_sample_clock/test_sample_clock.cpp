@@ -0,0 +1,148 @@
+#include <unity.h>
+#include "sample_clock.h"
+
+// Simulated time: each test services the schedule the way onSampleTimer() does,
+// with `now` chosen by the test instead of esp_timer_get_time().
+
+void setUp() {}
+void tearDown() {}
+
+static int64_t idealDeadlineUs(int64_t startUs, uint64_t tick, uint32_t rateHz) {
+    return startUs + (int64_t)(tick * 1000000ULL / rateHz);
+}
+
+// Services every deadline exactly on time for `ticks` ticks; returns the skips.
+static uint32_t runOnTime(SampleSchedule& s, uint64_t ticks) {
+    uint32_t skipped = 0;
+    for (uint64_t i = 0; i < ticks; i++) {
+        skipped += scheduleAdvance(s, scheduleDeadlineUs(s));
+    }
+    return skipped;
+}
+
+static void test_first_deadline_is_one_period_after_start() {
+    SampleSchedule s;
+    scheduleStart(s, 250, 1000);
+    TEST_ASSERT_EQUAL_INT64(1000 + 4000, scheduleDeadlineUs(s));
+}
+
+static void test_integer_periods_are_exact() {
+    const uint32_t rates[] = { 20, 100, 200, 250, 400, 500 };
+    for (uint32_t rate : rates) {
+        SampleSchedule s;
+        scheduleStart(s, rate, 0);
+        int64_t prev = 0;
+        for (int i = 0; i < 1000; i++) {
+            int64_t d = scheduleDeadlineUs(s);
+            TEST_ASSERT_EQUAL_INT64(1000000 / rate, d - prev);
+            prev = d;
+            scheduleAdvance(s, d);
+        }
+    }
+}
+
+// 333 Hz is 3003.003 us: periods alternate between 3003 and 3004 us so the
+// deadlines never wander from the ideal grid, even after an hour.
+static void test_non_integer_rate_does_not_drift() {
+    const uint32_t rate  = 333;
+    const int64_t  start = 123456789;
+    const uint64_t ticks = 333ULL * 3600;  // one hour
+
+    SampleSchedule s;
+    scheduleStart(s, rate, start);
+    int64_t prev = start;
+    for (uint64_t i = 1; i <= ticks; i++) {
+        int64_t d = scheduleDeadlineUs(s);
+        int64_t period = d - prev;
+        TEST_ASSERT_TRUE(period == 3003 || period == 3004);
+        prev = d;
+        scheduleAdvance(s, d);
+    }
+
+    // Tick `ticks` fell exactly one hour after start, to the microsecond.
+    TEST_ASSERT_EQUAL_INT64(start + 3600LL * 1000000, prev);
+    TEST_ASSERT_EQUAL_UINT32(0, s.skipped);
+}
+
+static void test_jittery_service_keeps_the_grid() {
+    // Late but within a period: every deadline still fires once and stays on the grid.
+    SampleSchedule s;
+    scheduleStart(s, 240, 0);
+    for (uint64_t tick = 1; tick <= 10000; tick++) {
+        int64_t d = scheduleDeadlineUs(s);
+        TEST_ASSERT_EQUAL_INT64(idealDeadlineUs(0, tick, 240), d);
+        TEST_ASSERT_EQUAL_UINT32(0, scheduleAdvance(s, d + (int64_t)(tick * 37 % 4000)));
+    }
+}
+
+static void test_late_service_counts_skipped_deadlines() {
+    SampleSchedule s;
+    scheduleStart(s, 250, 0);
+    runOnTime(s, 99);                        // deadline 100 is armed, at 400 ms
+    TEST_ASSERT_EQUAL_INT64(400000, scheduleDeadlineUs(s));
+
+    // Serviced 10.5 periods late: deadlines 101..110 have already passed.
+    uint32_t skipped = scheduleAdvance(s, 400000 + 10 * 4000 + 2000);
+    TEST_ASSERT_EQUAL_UINT32(10, skipped);
+    TEST_ASSERT_EQUAL_UINT32(10, s.skipped);
+
+    // Resumes at deadline 111, still on the original grid.
+    TEST_ASSERT_EQUAL_INT64(111 * 4000, scheduleDeadlineUs(s));
+
+    // Skips accumulate across late services.
+    scheduleAdvance(s, 111 * 4000 + 3 * 4000);
+    TEST_ASSERT_EQUAL_UINT32(13, s.skipped);
+}
+
+static void test_service_exactly_on_a_later_deadline_skips_it() {
+    SampleSchedule s;
+    scheduleStart(s, 100, 0);
+    // Armed for 10 ms, serviced at 30 ms: 20 and 30 ms have passed.
+    TEST_ASSERT_EQUAL_UINT32(2, scheduleAdvance(s, 30000));
+    TEST_ASSERT_EQUAL_INT64(40000, scheduleDeadlineUs(s));
+}
+
+// sampleTimerSetRate() restarts the schedule from "now": the new grid starts one
+// new period later, and skips from the old schedule are forgotten.
+static void test_restart_rebases_rate_and_clears_skips() {
+    SampleSchedule s;
+    scheduleStart(s, 100, 0);
+    runOnTime(s, 50);
+    scheduleAdvance(s, scheduleDeadlineUs(s) + 50000);
+    TEST_ASSERT_TRUE(s.skipped > 0);
+
+    const int64_t restartAt = 987654;
+    scheduleStart(s, 333, restartAt);
+    TEST_ASSERT_EQUAL_UINT32(0, s.skipped);
+    TEST_ASSERT_EQUAL_UINT32(333, s.rateHz);
+    TEST_ASSERT_EQUAL_INT64(restartAt + 3003, scheduleDeadlineUs(s));
+
+    runOnTime(s, 332);
+    TEST_ASSERT_EQUAL_INT64(restartAt + 1000000, scheduleDeadlineUs(s));
+}
+
+static void test_long_uptime_does_not_overflow() {
+    // A run started 49 days into uptime (past where a 32-bit millisecond or
+    // microsecond counter would have wrapped), then a 60 s stall.
+    const int64_t start = 49LL * 24 * 3600 * 1000000;
+    SampleSchedule s;
+    scheduleStart(s, 250, start);
+    int64_t later = start + 60LL * 1000000 + 1234;
+    scheduleAdvance(s, later);
+    TEST_ASSERT_TRUE(scheduleDeadlineUs(s) > later);
+    TEST_ASSERT_TRUE(scheduleDeadlineUs(s) <= later + 4000);
+    TEST_ASSERT_EQUAL_INT64(0, (scheduleDeadlineUs(s) - start) % 4000);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_deadline_is_one_period_after_start);
+    RUN_TEST(test_integer_periods_are_exact);
+    RUN_TEST(test_non_integer_rate_does_not_drift);
+    RUN_TEST(test_jittery_service_keeps_the_grid);
+    RUN_TEST(test_late_service_counts_skipped_deadlines);
+    RUN_TEST(test_service_exactly_on_a_later_deadline_skips_it);
+    RUN_TEST(test_restart_rebases_rate_and_clears_skips);
+    RUN_TEST(test_long_uptime_does_not_overflow);
+    return UNITY_END();
+}
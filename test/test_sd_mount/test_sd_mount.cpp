@@ -0,0 +1,191 @@
+#include <unity.h>
+#include "sd_mount.h"
+
+// Scriptable card. `present` is the card being seated; `mountFailures` makes
+// that many mount attempts fail even with the card present.
+struct FakeBlockDevice : BlockDevice {
+    bool present       = true;
+    int  mountFailures = 0;
+    int  mounts = 0, unmounts = 0, probes = 0;
+
+    bool mount() override {
+        mounts++;
+        if (!present) return false;
+        if (mountFailures > 0) { mountFailures--; return false; }
+        return true;
+    }
+    void unmount() override { unmounts++; }
+    bool probe() override { probes++; return present; }
+};
+
+void setUp() {}
+void tearDown() {}
+
+// Ticks every millisecond from `fromMs` to `toMs` inclusive, like a WiFiTask
+// loop would, and records when each mount attempt happened.
+static int tickUntil(SdMount& m, FakeBlockDevice& dev, uint32_t fromMs, uint32_t toMs,
+                     uint32_t* attemptsMs = nullptr, int maxAttempts = 0) {
+    int attempts = 0;
+    for (uint32_t t = fromMs; t <= toMs; t++) {
+        int before = dev.mounts;
+        sdMountTick(m, t);
+        if (dev.mounts != before && attemptsMs && attempts < maxAttempts) attemptsMs[attempts] = t;
+        attempts += dev.mounts - before;
+    }
+    return attempts;
+}
+
+static void test_begin_mounts_once() {
+    SdMount m;
+    FakeBlockDevice dev;
+    TEST_ASSERT_TRUE(sdMountBegin(m, dev, 0));
+    TEST_ASSERT_TRUE(m.state.load() == SdState::Mounted);
+    TEST_ASSERT_EQUAL(1, dev.mounts);
+    TEST_ASSERT_EQUAL_UINT32(1, m.mountCount);
+
+    // A healthy card is only probed, once per SD_PROBE_PERIOD_MS, never remounted.
+    tickUntil(m, dev, 1, 10 * SD_PROBE_PERIOD_MS);
+    TEST_ASSERT_EQUAL(1, dev.mounts);
+    TEST_ASSERT_EQUAL(10, dev.probes);
+}
+
+static void test_removal_is_detected_by_probe() {
+    SdMount m;
+    FakeBlockDevice dev;
+    sdMountBegin(m, dev, 0);
+
+    dev.present = false;
+    tickUntil(m, dev, 1, SD_PROBE_PERIOD_MS - 1);
+    TEST_ASSERT_TRUE(m.state.load() == SdState::Mounted);
+
+    sdMountTick(m, SD_PROBE_PERIOD_MS);
+    TEST_ASSERT_TRUE(m.state.load() == SdState::Lost);
+    TEST_ASSERT_EQUAL_UINT32(1, m.lostCount);
+    TEST_ASSERT_EQUAL(1, dev.unmounts);
+}
+
+static void test_remount_backoff_doubles_to_cap() {
+    SdMount m;
+    FakeBlockDevice dev;
+    sdMountBegin(m, dev, 0);
+    dev.present = false;
+    sdMountTick(m, SD_PROBE_PERIOD_MS);  // lost at t = 1000
+
+    uint32_t attempts[9] = {};
+    tickUntil(m, dev, SD_PROBE_PERIOD_MS + 1, 60000, attempts, 9);
+
+    // 250, 500, 1000, 2000, 4000, 8000, 8000 ... after each failed attempt.
+    const uint32_t expectedGaps[9] = { 250, 500, 1000, 2000, 4000, 8000, 8000, 8000, 8000 };
+    uint32_t prev = SD_PROBE_PERIOD_MS;
+    for (int i = 0; i < 9; i++) {
+        TEST_ASSERT_EQUAL_UINT32(expectedGaps[i], attempts[i] - prev);
+        prev = attempts[i];
+    }
+    TEST_ASSERT_TRUE(m.state.load() == SdState::Lost);
+}
+
+static void test_reinsertion_remounts_and_resets_backoff() {
+    SdMount m;
+    FakeBlockDevice dev;
+    sdMountBegin(m, dev, 0);
+    dev.present = false;
+    sdMountTick(m, 1000);
+    tickUntil(m, dev, 1001, 5000);  // attempts at 1250, 1750, 2750, 4750
+
+    dev.present = true;
+    tickUntil(m, dev, 5001, 8750);  // next attempt at 8750 succeeds
+    TEST_ASSERT_TRUE(m.state.load() == SdState::Mounted);
+    TEST_ASSERT_EQUAL_UINT32(2, m.mountCount);
+    TEST_ASSERT_EQUAL_UINT32(SD_REMOUNT_BACKOFF_MIN_MS, m.backoffMs);
+
+    // A second loss starts again from the minimum delay.
+    dev.present = false;
+    tickUntil(m, dev, 8751, 8750 + SD_PROBE_PERIOD_MS);
+    TEST_ASSERT_TRUE(m.state.load() == SdState::Lost);
+    int mountsBefore = dev.mounts;
+    uint32_t lostAt = 8750 + SD_PROBE_PERIOD_MS;
+    tickUntil(m, dev, lostAt + 1, lostAt + SD_REMOUNT_BACKOFF_MIN_MS - 1);
+    TEST_ASSERT_EQUAL(mountsBefore, dev.mounts);
+    sdMountTick(m, lostAt + SD_REMOUNT_BACKOFF_MIN_MS);
+    TEST_ASSERT_EQUAL(mountsBefore + 1, dev.mounts);
+}
+
+static void test_failed_boot_mount_is_retried() {
+    SdMount m;
+    FakeBlockDevice dev;
+    dev.mountFailures = 2;
+    TEST_ASSERT_FALSE(sdMountBegin(m, dev, 0));
+    TEST_ASSERT_TRUE(m.state.load() == SdState::Unmounted);
+
+    tickUntil(m, dev, 1, 249);
+    TEST_ASSERT_EQUAL(1, dev.mounts);
+    sdMountTick(m, 250);   // second failure
+    sdMountTick(m, 750);   // third attempt succeeds
+    TEST_ASSERT_TRUE(m.state.load() == SdState::Mounted);
+    TEST_ASSERT_EQUAL(3, dev.mounts);
+    TEST_ASSERT_EQUAL_UINT32(0, m.lostCount);
+}
+
+static void test_reported_failure_probes_on_next_tick() {
+    SdMount m;
+    FakeBlockDevice dev;
+    sdMountBegin(m, dev, 0);
+
+    dev.present = false;
+    sdReportFailure(m);
+    sdMountTick(m, 10);  // well before the periodic probe is due
+    TEST_ASSERT_TRUE(m.state.load() == SdState::Lost);
+    TEST_ASSERT_EQUAL(1, dev.probes);
+}
+
+static void test_spurious_report_keeps_card_mounted() {
+    SdMount m;
+    FakeBlockDevice dev;
+    sdMountBegin(m, dev, 0);
+
+    sdReportFailure(m);
+    sdMountTick(m, 10);
+    TEST_ASSERT_TRUE(m.state.load() == SdState::Mounted);
+    TEST_ASSERT_EQUAL(1, dev.probes);
+    TEST_ASSERT_FALSE(m.failureReported.load());
+    TEST_ASSERT_EQUAL_UINT32(0, m.lostCount);
+
+    // The next periodic probe is a full period after the confirming one.
+    tickUntil(m, dev, 11, 10 + SD_PROBE_PERIOD_MS - 1);
+    TEST_ASSERT_EQUAL(1, dev.probes);
+    sdMountTick(m, 10 + SD_PROBE_PERIOD_MS);
+    TEST_ASSERT_EQUAL(2, dev.probes);
+}
+
+static void test_deadlines_survive_millis_wraparound() {
+    SdMount m;
+    FakeBlockDevice dev;
+    const uint32_t start = UINT32_MAX - 500;
+    sdMountBegin(m, dev, start);
+
+    dev.present = false;
+    sdMountTick(m, start + 999);  // wraps; still short of the probe period
+    TEST_ASSERT_TRUE(m.state.load() == SdState::Mounted);
+    sdMountTick(m, start + SD_PROBE_PERIOD_MS);
+    TEST_ASSERT_TRUE(m.state.load() == SdState::Lost);
+}
+
+static void test_state_names() {
+    TEST_ASSERT_EQUAL_STRING("mounted", sdStateName(SdState::Mounted));
+    TEST_ASSERT_EQUAL_STRING("lost", sdStateName(SdState::Lost));
+    TEST_ASSERT_EQUAL_STRING("unmounted", sdStateName(SdState::Unmounted));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_begin_mounts_once);
+    RUN_TEST(test_removal_is_detected_by_probe);
+    RUN_TEST(test_remount_backoff_doubles_to_cap);
+    RUN_TEST(test_reinsertion_remounts_and_resets_backoff);
+    RUN_TEST(test_failed_boot_mount_is_retried);
+    RUN_TEST(test_reported_failure_probes_on_next_tick);
+    RUN_TEST(test_spurious_report_keeps_card_mounted);
+    RUN_TEST(test_deadlines_survive_millis_wraparound);
+    RUN_TEST(test_state_names);
+    return UNITY_END();
+}